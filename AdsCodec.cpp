@@ -1,5 +1,8 @@
 #include "AdsCodec.h"
 
+#include <algorithm>
+#include <array>
+
 namespace Ads
 {
 QTextCodec * codec()
@@ -7,4 +10,61 @@ QTextCodec * codec()
   static auto codec = QTextCodec::codecForName("Windows-1252");
   return codec;
 }
+
+QString toUnicode(QByteArrayView raw)
+{
+  return codec()->toUnicode(raw.data(), int(raw.size()));
+}
+
+// Maps each Windows-1252 character to its case-folded form, if that has a
+// Windows-1252 representation, too.
+static const std::array<char, 256> & caseFoldTable()
+{
+  static const auto table = []
+  {
+    std::array<char, 256> table;
+    for (int byte = 0; byte < 256; ++byte)
+    {
+      auto raw = char(byte);
+      auto folded = codec()->toUnicode(&raw, 1).toCaseFolded();
+      auto encoded = codec()->fromUnicode(folded);
+      table[byte] = encoded.size() == 1 && codec()->toUnicode(encoded) == folded ? encoded[0] : raw;
+    }
+    return table;
+  }();
+  return table;
+}
+
+void appendFoldedCase(QByteArray & folded, QByteArrayView raw)
+{
+  const auto & table = caseFoldTable();
+  auto size = folded.size();
+  folded.resize(size + raw.size());
+  auto out = folded.data() + size;
+  for (auto c : raw)
+    *out++ = table[uchar(c)];
+}
+
+QByteArray foldCase(QByteArrayView raw)
+{
+  QByteArray folded;
+  appendFoldedCase(folded, raw);
+  return folded;
+}
+
+bool equalsFoldedCase(QByteArrayView raw, QByteArrayView folded)
+{
+  const auto & table = caseFoldTable();
+  return raw.size() == folded.size() &&
+         std::equal(raw.begin(), raw.end(), folded.begin(),
+                    [&table](char r, char f) { return table[uchar(r)] == f; });
+}
+
+bool containsFoldedCase(QByteArrayView raw, QByteArrayView folded)
+{
+  const auto & table = caseFoldTable();
+  return folded.isEmpty() ||
+         std::search(raw.begin(), raw.end(), folded.begin(), folded.end(),
+                     [&table](char r, char f) { return table[uchar(r)] == f; }) != raw.end();
+}
 } // namespace Ads
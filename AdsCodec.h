@@ -1,8 +1,21 @@
 #pragma once
 
+#include <QByteArray>
+#include <QByteArrayView>
 #include <QTextCodec>
 
 namespace Ads
 {
 QTextCodec * codec();
-}
+
+// Decodes a raw (Windows-1252) name or comment from an upload.
+QString toUnicode(QByteArrayView raw);
+
+// Appends raw to folded with each character case-folded, so that raw names
+// can be compared case-insensitively without decoding them.
+void appendFoldedCase(QByteArray & folded, QByteArrayView raw);
+QByteArray foldCase(QByteArrayView raw);
+// Compare raw text to text that is case-folded already, without allocating.
+bool equalsFoldedCase(QByteArrayView raw, QByteArrayView folded);
+bool containsFoldedCase(QByteArrayView raw, QByteArrayView folded);
+} // namespace Ads
@@ -16,6 +16,8 @@
 
 #include <cstdint>
 
+#include <QByteArrayView>
+
 #pragma pack(push, 1)
 
 #define ADSDATATYPEFLAG_DATATYPE 1
@@ -104,6 +106,9 @@ struct AdsDatatypeEntry
   {
     return type() + typeLength + 1;
   }
+  QByteArrayView rawName() const { return QByteArrayView(name(), nameLength); }
+  QByteArrayView rawType() const { return QByteArrayView(type(), typeLength); }
+  QByteArrayView rawComment() const { return QByteArrayView(comment(), commentLength); }
   const AdsDatatypeArrayInfo * arrayInfo() const
   {
     return reinterpret_cast<const AdsDatatypeArrayInfo *>(comment() + commentLength + 1);
@@ -6,47 +6,200 @@
 #include <QDebug>
 #include <QFile>
 
+AdsDatatypeIndex::AdsDatatypeIndex(const QByteArray & dataTypeUpload, const QByteArray & nameTable,
+                                   std::shared_ptr<const void> backing)
+    : mDataTypeUpload(dataTypeUpload), mBacking(std::move(backing))
+{
+  auto table = AdsNameTable::fromData(nameTable, mDataTypeUpload.size());
+  if (isValid(table))
+  {
+    mNameTable = table;
+    mBuildPosition = mDataTypeUpload.size();
+    resolve();
+    return;
+  }
+  qWarning() << "Cached datatype name table does not match the upload. Rebuilding.";
+  build(mDataTypeUpload.size());
+}
+
 AdsDatatypeIndex::~AdsDatatypeIndex()
 {
   qDeleteAll(mEntries);
 }
 
-void AdsDatatypeIndex::build()
+bool AdsDatatypeIndex::isValid(const AdsNameTable & nameTable) const
 {
-  auto end = mDataTypeUpload.constData() + mDataTypeUpload.size();
-  auto current =
-      reinterpret_cast<const AdsDatatypeEntry *>(mDataTypeUpload.constData());
+  if (nameTable.isEmpty())
+    return false;
+  auto size = uint64_t(mDataTypeUpload.size());
+  for (uint32_t i = 0; i < nameTable.count(); ++i)
+  {
+    auto offset = nameTable.offset(i);
+    if (offset + sizeof(AdsDatatypeEntry) > size)
+      return false;
+    auto current = reinterpret_cast<const AdsDatatypeEntry *>(mDataTypeUpload.constData() + offset);
+    if (offset + uint64_t(current->entryLength) > size ||
+        sizeof(AdsDatatypeEntry) + uint64_t(current->nameLength) + current->typeLength + current->commentLength + 3 > current->entryLength)
+      return false;
+  }
+  return true;
+}
 
-  while (reinterpret_cast<const char *>(current) < end)
+void AdsDatatypeIndex::build(qsizetype bytesAvailable)
+{
+  while (mBuildPosition + qsizetype(sizeof(AdsDatatypeEntry)) <= bytesAvailable)
   {
-    auto next = reinterpret_cast<const AdsDatatypeEntry *>(
-        reinterpret_cast<const char *>(current) + current->entryLength);
-    if (reinterpret_cast<const char *>(next) > end)
+    auto current =
+        reinterpret_cast<const AdsDatatypeEntry *>(mDataTypeUpload.constData() + mBuildPosition);
+    if (Q_UNLIKELY(current->entryLength == 0))
     {
-      qCritical() << "Datatype record extends past end of buffer. Skipped.";
+      qCritical() << "Datatype record of zero length. Skipped the rest.";
+      mBuildPosition = mDataTypeUpload.size();
+      break;
+    }
+    if (mBuildPosition + qsizetype(current->entryLength) > bytesAvailable)
       break;
+    mBuildOffsets << uint32_t(mBuildPosition);
+    mBuildHashes << AdsNameTable::hash(QByteArrayView(current->name(), current->nameLength));
+    mBuildPosition += current->entryLength;
+  }
+
+  if (bytesAvailable < mDataTypeUpload.size())
+    return; // more to come
+
+  if (mBuildPosition < mDataTypeUpload.size())
+    qCritical() << "Datatype record extends past end of buffer. Skipped.";
+  mBuildPosition = mDataTypeUpload.size();
+  mNameTable = AdsNameTable(mBuildOffsets, mBuildHashes);
+  mBuildOffsets.clear();
+  mBuildHashes.clear();
+  resolve();
+}
+
+void AdsDatatypeIndex::resolve()
+{
+  QList<const AdsDatatypeEntry *> stack;
+  stack.reserve(count());
+  for (qsizetype i = count() - 1; i >= 0; --i)
+    stack << record(i);
+
+  mResolutions.reserve(count());
+  while (!stack.isEmpty())
+  {
+    auto adsType = stack.takeLast();
+    auto currentChild = adsType->subItems();
+    for (int iChild = 0; iChild < adsType->subItemCount; ++iChild)
+    {
+      stack << currentChild;
+      currentChild = reinterpret_cast<const AdsDatatypeEntry *>(
+          reinterpret_cast<const char *>(currentChild) + currentChild->entryLength);
+    }
+
+    Resolution resolution;
+    resolution.declaration = adsType->typeLength == 0 ? adsType : lookupRecord(adsType->rawType());
+    if (Q_UNLIKELY(!resolution.declaration))
+    {
+      qCritical() << "Unresolved type" << Ads::toUnicode(adsType->rawType()) << "in" << Ads::toUnicode(adsType->rawName());
+    }
+    else
+    {
+      resolution.arrayCount = arrayCount(resolution.declaration);
+      resolution.childCount = resolution.declaration->subItemCount + resolution.arrayCount;
     }
-    auto currentName = Ads::codec()->toUnicode(current->name());
-    mNameRawIndex[currentName] = current;
-    auto entry = new Entry(currentName, 0, current);
-    mEntries << entry;
-    mNameIndex[currentName] = entry;
-    current = next;
+    mResolutions.insert(adsType, resolution);
+  }
+
+  for (auto it = mResolutions.keyBegin(); it != mResolutions.keyEnd(); ++it)
+    countDescendants(*it);
+}
+
+// Marks a count being worked out, to detect types that contain themselves.
+static constexpr quint64 Counting = ~quint64(0);
+
+quint64 AdsDatatypeIndex::countDescendants(const AdsDatatypeEntry * adsType)
+{
+  auto it = mResolutions.find(adsType);
+  if (Q_UNLIKELY(it == mResolutions.end()))
+    return 0;
+  if (it->descendantCount == Counting)
+  {
+    qCritical() << "Type" << Ads::toUnicode(adsType->rawType()) << "of" << Ads::toUnicode(adsType->rawName()) << "contains itself.";
+    return 0;
+  }
+  if (it->descendantCount != 0 || it->childCount == 0)
+    return it->descendantCount; // counted before, or a leaf
+
+  auto declaration = it->declaration;
+  auto arrayCount = it->arrayCount;
+  it->descendantCount = Counting;
+  quint64 count = 0;
+  auto currentChild = declaration->subItems();
+  for (int iChild = 0; iChild < declaration->subItemCount; ++iChild)
+  {
+    count += 1 + countDescendants(currentChild);
+    currentChild = reinterpret_cast<const AdsDatatypeEntry *>(
+        reinterpret_cast<const char *>(currentChild) + currentChild->entryLength);
+  }
+  if (arrayCount)
+    count += arrayCount * (1 + countDescendants(declaration));
+  it->descendantCount = count;
+  return count;
+}
+
+auto AdsDatatypeIndex::resolution(const AdsDatatypeEntry * adsType) const -> const Resolution &
+{
+  static const Resolution unresolved;
+  auto it = mResolutions.constFind(adsType);
+  Q_ASSERT(it != mResolutions.constEnd());
+  return it != mResolutions.constEnd() ? *it : unresolved;
+}
+
+auto AdsDatatypeIndex::entry(qsizetype i) const -> const Entry *
+{
+  if (mEntries.isEmpty())
+    mEntries.resize(count(), nullptr);
+  if (!mEntries[i])
+  {
+    auto adsType = record(i);
+    mEntries[i] = new Entry(QByteArray::fromRawData(adsType->name(), adsType->nameLength), 0, adsType);
   }
+  return mEntries[i];
 }
 
-AdsDatatypeIndex::Entry::Entry(const QString & name, uint32_t offset, const AdsDatatypeEntry * _adsType, const Entry * _parent)
+qsizetype AdsDatatypeIndex::find(QByteArrayView name) const
+{
+  return mNameTable.find(name,
+                         [this](uint32_t offset)
+                         {
+                           auto adsType = reinterpret_cast<const AdsDatatypeEntry *>(mDataTypeUpload.constData() + offset);
+                           return adsType->rawName();
+                         });
+}
+
+auto AdsDatatypeIndex::lookup(QByteArrayView name) const -> const Entry *
+{
+  auto ordinal = find(name);
+  return ordinal < 0 ? nullptr : entry(ordinal);
+}
+
+const AdsDatatypeEntry * AdsDatatypeIndex::lookupRecord(QByteArrayView name) const
+{
+  auto ordinal = find(name);
+  return ordinal < 0 ? nullptr : record(ordinal);
+}
+
+AdsDatatypeIndex::Entry::Entry(const QByteArray & name, uint32_t offset, const AdsDatatypeEntry * _adsType, const Entry * _parent)
     : mParent(_parent), mName(name), mOffset(offset), mAdsType(_adsType)
 {
 }
 
 AdsDatatypeIndex::Entry::~Entry()
 {
-  qDeleteAll(mChildren);
+  qDeleteAll(mMembers);
+  qDeleteAll(mElements);
 }
 
-// static
-int AdsDatatypeIndex::Entry::arrayCount(const AdsDatatypeEntry * adsType, const AdsDatatypeIndex & index)
+int AdsDatatypeIndex::arrayCount(const AdsDatatypeEntry * adsType) const
 {
   if (adsType->arrayDim == 0)
     return 0;
@@ -56,11 +209,11 @@ int AdsDatatypeIndex::Entry::arrayCount(const AdsDatatypeEntry * adsType, const
     auto arrayInfo = adsType->arrayInfo()[iArrayDim];
     count *= arrayInfo.elements;
   }
-  auto type = index.mNameRawIndex.value(Ads::codec()->toUnicode(adsType->type()));
+  auto type = lookupRecord(adsType->rawType());
   if (Q_UNLIKELY(!type))
   {
-    qCritical() << "Unresolved type" << Ads::codec()->toUnicode(adsType->type())
-                << "in" << Ads::codec()->toUnicode(adsType->name());
+    qCritical() << "Unresolved type" << Ads::toUnicode(adsType->rawType())
+                << "in" << Ads::toUnicode(adsType->rawName());
   }
   else if (Q_UNLIKELY(count * type->size != adsType->size))
   {
@@ -69,110 +222,89 @@ int AdsDatatypeIndex::Entry::arrayCount(const AdsDatatypeEntry * adsType, const
   return count;
 }
 
-static QStringList expandArrayIndices(const AdsDatatypeEntry * adsType)
+// static
+QByteArray AdsDatatypeIndex::arrayIndexName(const AdsDatatypeEntry * adsType, int element)
 {
-  auto arrayIndices = QList{QString()};
+  QByteArray name(1, ']');
   for (int iArrayDim = adsType->arrayDim - 1; iArrayDim >= 0; --iArrayDim)
   {
     auto arrayInfo = adsType->arrayInfo()[iArrayDim];
-    auto newArrayIndices = QList<QString>();
-    for (uint i = arrayInfo.lBound; i < arrayInfo.lBound + arrayInfo.elements; ++i)
-    {
-      for (const auto & name : arrayIndices)
-      {
-        if (name.isEmpty())
-          newArrayIndices << QString::number(i);
-        else
-          newArrayIndices << QString::number(i) + "," + name;
-      }
-    }
-    arrayIndices = newArrayIndices;
+    name.prepend(QByteArray::number(arrayInfo.lBound + uint32_t(element) % arrayInfo.elements));
+    name.prepend(iArrayDim > 0 ? ',' : '[');
+    element /= arrayInfo.elements;
   }
-  arrayIndices.removeIf([](const QString & index)
-                        { return index.isNull(); });
-  return arrayIndices;
+  return name;
 }
 
 int AdsDatatypeIndex::Entry::childCount(const AdsDatatypeIndex & index) const
 {
-  if (mChildrenLoaded)
-    return mChildren.count();
-
-  auto codec = Ads::codec();
-  auto typeName = codec->toUnicode(mAdsType->type());
-  auto declaration = !typeName.isEmpty() ? index.mNameRawIndex.value(typeName) : mAdsType;
-
-  if (Q_UNLIKELY(!declaration))
-  {
-    qCritical() << "Unresolved type" << typeName << "in" << codec->toUnicode(mAdsType->name());
-    return 0;
-  }
-
-  return declaration->subItemCount + arrayCount(declaration, index);
+  return index.resolution(mAdsType).childCount;
 }
 
-auto AdsDatatypeIndex::Entry::children(const AdsDatatypeIndex & index) const -> QList<const Entry *>
+int AdsDatatypeIndex::Entry::memberCount(const AdsDatatypeIndex & index) const
 {
-  if (mChildrenLoaded)
-    return mChildren;
-
-  mChildrenLoaded = true;
-
-  auto codec = Ads::codec();
-  auto typeName = codec->toUnicode(mAdsType->type());
-  auto declaration = !typeName.isEmpty() ? index.mNameRawIndex.value(typeName) : mAdsType;
+  auto declaration = index.resolution(mAdsType).declaration;
+  return declaration ? declaration->subItemCount : 0;
+}
 
-  if (Q_UNLIKELY(!declaration))
-  {
-    qCritical() << "Unresolved type" << typeName << "in" << codec->toUnicode(mAdsType->name());
-    return mChildren;
-  }
+auto AdsDatatypeIndex::Entry::child(int row, const AdsDatatypeIndex & index) const -> const Entry *
+{
+  const auto & resolution = index.resolution(mAdsType);
+  auto declaration = resolution.declaration;
+  if (Q_UNLIKELY(!declaration || row < 0 || row >= resolution.childCount))
+    return nullptr;
 
-  auto currentChild = declaration->subItems();
-  for (int iChild = 0; iChild < declaration->subItemCount; ++iChild)
+  if (row < declaration->subItemCount)
   {
-    mChildren << new Entry(codec->toUnicode(currentChild->name()), currentChild->offs, currentChild, this);
-    currentChild = reinterpret_cast<const AdsDatatypeEntry *>(
-        reinterpret_cast<const char *>(currentChild) + currentChild->entryLength);
+    if (mMembers.isEmpty())
+    {
+      mMembers.reserve(declaration->subItemCount);
+      auto currentChild = declaration->subItems();
+      for (int iChild = 0; iChild < declaration->subItemCount; ++iChild)
+      {
+        mMembers << new Entry(QByteArray::fromRawData(currentChild->name(), currentChild->nameLength), currentChild->offs, currentChild, this);
+        currentChild = reinterpret_cast<const AdsDatatypeEntry *>(
+            reinterpret_cast<const char *>(currentChild) + currentChild->entryLength);
+      }
+    }
+    return mMembers[row];
   }
 
-  auto arrayIndices = expandArrayIndices(declaration);
-  if (arrayIndices.isEmpty())
-    return mChildren;
-
-  if (declaration->size % arrayIndices.count() != 0)
-  {
-    qCritical() << "Size of" << codec->toUnicode(declaration->name()) << "is not divisible by the number of array indices:" << arrayIndices.count();
-    return mChildren;
-  }
-  auto itemSize = declaration->size / arrayIndices.count();
-  auto offset = declaration->offs;
-  if (Q_UNLIKELY(declaration->offs))
+  auto element = row - declaration->subItemCount;
+  auto & child = mElements[element];
+  if (!child)
   {
-    qWarning() << "Offset of" << codec->toUnicode(declaration->name()) << "is not zero, but" << declaration->offs;
-    Q_ASSERT(false);
-  }
-  for (const auto & arrayIndex : expandArrayIndices(declaration))
-  {
-    mChildren << new Entry("[" + arrayIndex + "]", offset, declaration, this);
-    offset += itemSize;
+    if (Q_UNLIKELY(declaration->offs))
+    {
+      qWarning() << "Offset of" << Ads::toUnicode(declaration->rawName()) << "is not zero, but" << declaration->offs;
+      Q_ASSERT(false);
+    }
+    auto itemSize = declaration->size / resolution.arrayCount;
+    child = new Entry(arrayIndexName(declaration, element), declaration->offs + element * itemSize, declaration, this);
   }
+  return child;
+}
 
-  Q_ASSERT(offset == declaration->size);
-
-  return mChildren;
+QString AdsDatatypeIndex::Entry::name() const
+{
+  return Ads::toUnicode(mName);
 }
 
-QString AdsDatatypeIndex::Entry::fullName() const
+QByteArray AdsDatatypeIndex::Entry::rawFullName() const
 {
   if (!mParent)
-    return QString(); // do not want the type name in the full name
-  auto result = mParent->fullName();
+    return QByteArray(); // do not want the type name in the full name
+  auto result = mParent->rawFullName();
   if (result.isNull())
     return mName;
   if (mName.startsWith('['))
-    return result + name();
-  return result + "." + name();
+    return result + mName;
+  return result + '.' + mName;
+}
+
+QString AdsDatatypeIndex::Entry::fullName() const
+{
+  return Ads::toUnicode(rawFullName());
 }
 
 uint32_t AdsDatatypeIndex::Entry::offset() const
@@ -1,7 +1,13 @@
 #pragma once
 
+#include "AdsNameTable.h"
+
 #include <QByteArray>
+#include <QByteArrayView>
 #include <QHash>
+#include <QList>
+
+#include <memory>
 
 struct AdsDatatypeEntry;
 
@@ -10,58 +16,122 @@ class AdsDatatypeIndex
 public: // types
   class Entry;
 
+  // What a record's type name stands for, worked out once by resolve() for
+  // every record and sub-item, so navigating the tree needs no name lookups.
+  struct Resolution
+  {
+    // The record that holds the sub-items and array bounds: the record of the
+    // named type, or the record itself if it has no type name. nullptr if the
+    // type is unknown.
+    const AdsDatatypeEntry * declaration = nullptr;
+    // Elements of the declaration, 0 if it is no array or its size does not
+    // match the element type.
+    int arrayCount = 0;
+    // Sub-items plus array elements.
+    int childCount = 0;
+    // Rows below, at all levels.
+    quint64 descendantCount = 0;
+  };
+
 public: // methods
-  AdsDatatypeIndex(const QByteArray & dataTypeUpload)
-      : mDataTypeUpload(dataTypeUpload)
+  // backing keeps the memory alive, if the upload is a QByteArray::fromRawData()
+  // view, e.g. into a mapped cache file.
+  AdsDatatypeIndex(const QByteArray & dataTypeUpload, std::shared_ptr<const void> backing = nullptr)
+      : mDataTypeUpload(dataTypeUpload), mBacking(std::move(backing))
+  {
+    build(mDataTypeUpload.size());
+  }
+  // Reuses a name table built for this upload before (see nameTable()), if it
+  // is valid, instead of walking all records.
+  AdsDatatypeIndex(const QByteArray & dataTypeUpload, const QByteArray & nameTable,
+                   std::shared_ptr<const void> backing = nullptr);
+  // Streaming construction: the upload is written to uploadBuffer() piece by
+  // piece and build() indexes the records that are complete so far.
+  explicit AdsDatatypeIndex(qsizetype uploadSize)
+      : mDataTypeUpload(uploadSize, Qt::Uninitialized)
   {
-    build();
   }
   AdsDatatypeIndex(AdsDatatypeIndex &&) = default;
   Q_DISABLE_COPY(AdsDatatypeIndex)
 
   ~AdsDatatypeIndex();
 
-  auto lookup(const QString & name) const
+  qsizetype count() const { return mNameTable.count(); }
+  const AdsDatatypeEntry * record(qsizetype i) const
   {
-    return mNameIndex.value(name, nullptr);
+    return reinterpret_cast<const AdsDatatypeEntry *>(mDataTypeUpload.constData() + mNameTable.offset(i));
   }
+  // The top-level entries are created on first use.
+  const Entry * entry(qsizetype i) const;
+
+  // name is the raw (Windows-1252) type name as found in the upload.
+  const Entry * lookup(QByteArrayView name) const;
 
-  const auto & entries() const { return mEntries; }
+  // name is the raw type name. Unlike lookup(), this creates no Entry and may
+  // be used from several threads once all records are indexed.
+  const AdsDatatypeEntry * lookupRecord(QByteArrayView name) const;
+
+  // adsType is a record or sub-item in the upload. Available once all records
+  // are indexed.
+  const Resolution & resolution(const AdsDatatypeEntry * adsType) const;
+
+  // The "[i,j]" index of element number element of the array adsType, the
+  // last dimension varying fastest.
+  static QByteArray arrayIndexName(const AdsDatatypeEntry * adsType, int element);
+
+  const QByteArray & upload() const { return mDataTypeUpload; }
+  const AdsNameTable & nameTable() const { return mNameTable; }
+
+  char * uploadBuffer() { return mDataTypeUpload.data(); }
+  void build(qsizetype bytesAvailable);
 
 private: // methods
-  void build();
+  bool isValid(const AdsNameTable & nameTable) const;
+  void resolve();
+  int arrayCount(const AdsDatatypeEntry * adsType) const;
+  quint64 countDescendants(const AdsDatatypeEntry * adsType);
+  qsizetype find(QByteArrayView name) const;
 
 private: // attributes
   QByteArray mDataTypeUpload;
-  QHash<QString, const AdsDatatypeEntry *> mNameRawIndex;
-  QList<const Entry *> mEntries;
-  QHash<QString, const Entry *> mNameIndex;
+  std::shared_ptr<const void> mBacking;
+  qsizetype mBuildPosition = 0;
+  QList<uint32_t> mBuildOffsets;
+  QList<uint32_t> mBuildHashes;
+  AdsNameTable mNameTable;
+  QHash<const AdsDatatypeEntry *, Resolution> mResolutions;
+  mutable QList<const Entry *> mEntries;
 };
 
 class AdsDatatypeIndex::Entry
 {
 public: // methods
-  Entry(const QString & name, uint32_t offset, const AdsDatatypeEntry * adsType, const Entry * parent = nullptr);
+  // name is the raw name; members refer to it in the upload, array elements
+  // own their "[i,j]" index.
+  Entry(const QByteArray & name, uint32_t offset, const AdsDatatypeEntry * adsType, const Entry * parent = nullptr);
   ~Entry();
   Q_DISABLE_COPY(Entry)
 
   const Entry * parent() const { return mParent; }
   const AdsDatatypeEntry * adsType() const { return mAdsType; }
+  // The members come first, then the array elements. Children are created on
+  // first use; array elements one by one, so that only the elements actually
+  // visited take memory.
   int childCount(const AdsDatatypeIndex & index) const;
-  QList<const Entry *> children(const AdsDatatypeIndex & index) const;
+  int memberCount(const AdsDatatypeIndex & index) const;
+  const Entry * child(int row, const AdsDatatypeIndex & index) const;
 
-  QString name() const { return mName; }
+  const QByteArray & rawName() const { return mName; }
+  QString name() const;
   QString fullName() const;
+  QByteArray rawFullName() const;
   uint32_t offset() const;
 
-private: // methods
-  static int arrayCount(const AdsDatatypeEntry * adsType, const AdsDatatypeIndex & index);
-
 private: // attributes
   const Entry * mParent = nullptr;
-  QString mName;
+  QByteArray mName;
   uint32_t mOffset = 0;
   const AdsDatatypeEntry * mAdsType = nullptr;
-  mutable bool mChildrenLoaded = false;
-  mutable QList<const Entry *> mChildren;
+  mutable QList<const Entry *> mMembers;
+  mutable QHash<int, const Entry *> mElements;
 };
@@ -0,0 +1,85 @@
+#include "AdsLeafLayout.h"
+
+#include <QMutexLocker>
+
+AdsLeafLayout::AdsLeafLayout(const AdsDatatypeIndex & typeIndex, const AdsDatatypeIndex::Resolution & resolution)
+    : mDeclaration(resolution.declaration)
+{
+  mLeafCount = append(typeIndex, resolution, 0, QByteArray());
+  mItems.squeeze();
+}
+
+// Appends the items below a row of the given resolution, which starts at
+// offset and is found at path, the same way AdsPathSpace walks it. Returns the
+// number of leaves with the array elements expanded.
+quint64 AdsLeafLayout::append(const AdsDatatypeIndex & typeIndex, const AdsDatatypeIndex::Resolution & resolution,
+                              uint32_t offset, const QByteArray & path)
+{
+  auto declaration = resolution.declaration;
+  quint64 leafCount = 0;
+
+  auto member = declaration->subItems();
+  for (int iMember = 0; iMember < declaration->subItemCount; ++iMember)
+  {
+    auto memberPath = path;
+    memberPath.append('.').append(member->rawName());
+    const auto & memberResolution = typeIndex.resolution(member);
+    if (AdsLeafLayouts::isLeaf(memberResolution))
+    {
+      mItems << Item{offset + member->offs, member->size, 0, AdsDatatypeId(member->dataType),
+                     mItems.size() + 1, nullptr, memberPath};
+      ++leafCount;
+    }
+    else
+    {
+      leafCount += append(typeIndex, memberResolution, offset + member->offs, memberPath);
+    }
+    member = reinterpret_cast<const AdsDatatypeEntry *>(
+        reinterpret_cast<const char *>(member) + member->entryLength);
+  }
+
+  if (resolution.arrayCount == 0)
+    return leafCount;
+
+  // The elements are described once, relative to the start of an element.
+  auto itemSize = declaration->size / uint32_t(resolution.arrayCount);
+  auto arrayItem = mItems.size();
+  mItems << Item{offset + declaration->offs, itemSize, uint32_t(resolution.arrayCount), AdsDatatypeId::Void,
+                 0, declaration, path};
+  quint64 elementLeafCount = 1;
+  const auto & elementResolution = typeIndex.resolution(declaration);
+  if (AdsLeafLayouts::isLeaf(elementResolution))
+    mItems << Item{0, itemSize, 0, AdsDatatypeId(declaration->dataType), mItems.size() + 1, nullptr, QByteArray()};
+  else
+    elementLeafCount = append(typeIndex, elementResolution, 0, QByteArray());
+  mItems[arrayItem].end = mItems.size();
+  return leafCount + elementLeafCount * uint32_t(resolution.arrayCount);
+}
+
+AdsLeafLayouts::AdsLeafLayouts(const AdsDatatypeIndex & typeIndex)
+    : mTypeIndex(typeIndex)
+{
+}
+
+std::shared_ptr<const AdsLeafLayout> AdsLeafLayouts::layout(const AdsDatatypeEntry * adsType) const
+{
+  const auto & resolution = mTypeIndex.resolution(adsType);
+  if (isLeaf(resolution))
+    return nullptr;
+
+  auto declaration = resolution.declaration;
+  {
+    QMutexLocker locker(&mMutex);
+    if (auto layout = mLayouts.value(declaration))
+      return layout;
+  }
+
+  // Built without the lock, so that other types need not wait. If two threads
+  // build the same layout, the first one to finish is kept.
+  std::shared_ptr<const AdsLeafLayout> layout(new AdsLeafLayout(mTypeIndex, resolution));
+  QMutexLocker locker(&mMutex);
+  auto & cached = mLayouts[declaration];
+  if (!cached)
+    cached = layout;
+  return cached;
+}
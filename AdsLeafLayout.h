@@ -0,0 +1,132 @@
+#pragma once
+
+#include "AdsDatatypeEntry.h"
+#include "AdsDatatypeIndex.h"
+
+#include <QByteArray>
+#include <QHash>
+#include <QList>
+#include <QMutex>
+
+#include <cstdint>
+#include <memory>
+
+// The primitive leaves of a type, each with its path relative to a value of
+// the type, its offset, size and AdsDatatypeId, in the preorder of
+// AdsPathSpace. Struct members are flattened into their parent. An array is
+// a single item standing for all its elements: the items after it, up to
+// end, describe one element relative to its start, and repeat count times
+// size bytes apart.
+//
+// Immutable once built, so any number of threads may use it.
+class AdsLeafLayout
+{
+public: // types
+  struct Item
+  {
+    uint32_t offset;       // relative to the enclosing element, or the value
+    uint32_t size;         // of a leaf; of one element for an array
+    uint32_t count;        // elements of an array, 0 for a leaf
+    AdsDatatypeId type;    // of a leaf
+    qsizetype end;         // past the items describing an element of an array
+    const AdsDatatypeEntry * array; // for AdsDatatypeIndex::arrayIndexName()
+    QByteArray path;       // raw, relative, e.g. ".axis"; without the index of an array
+  };
+
+public: // methods
+  const AdsDatatypeEntry * declaration() const { return mDeclaration; }
+  const QList<Item> & items() const { return mItems; }
+  // Leaves with all array elements expanded
+  quint64 leafCount() const { return mLeafCount; }
+
+  // Calls visit(offset, leaf, path) for all leaves with the array elements
+  // expanded, in preorder. offset is relative to the value, path the full
+  // relative path. Stops early if visit returns false.
+  template <typename Visit>
+  void forEachLeaf(Visit && visit) const;
+
+private: // methods
+  friend class AdsLeafLayouts;
+  AdsLeafLayout(const AdsDatatypeIndex & typeIndex, const AdsDatatypeIndex::Resolution & resolution);
+  quint64 append(const AdsDatatypeIndex & typeIndex, const AdsDatatypeIndex::Resolution & resolution,
+                 uint32_t offset, const QByteArray & path);
+
+  template <typename Visit>
+  bool visitItems(qsizetype first, qsizetype last, uint64_t base, QByteArray & path, Visit & visit) const;
+
+private: // attributes
+  const AdsDatatypeEntry * mDeclaration = nullptr;
+  QList<Item> mItems;
+  quint64 mLeafCount = 0;
+};
+
+// The leaf layouts of the types in a datatype index. Each is built when it is
+// first asked for, keyed by the record declaring the type, and then shared by
+// every value of that type. Thread-safe.
+class AdsLeafLayouts
+{
+public: // methods
+  // The index must outlive the layouts.
+  explicit AdsLeafLayouts(const AdsDatatypeIndex & typeIndex);
+  Q_DISABLE_COPY(AdsLeafLayouts)
+
+  const AdsDatatypeIndex & typeIndex() const { return mTypeIndex; }
+
+  // adsType is the record describing a row, as in
+  // AdsDatatypeIndex::Entry::adsType(). nullptr for primitives, which are
+  // a single leaf of adsType->dataType and adsType->size.
+  std::shared_ptr<const AdsLeafLayout> layout(const AdsDatatypeEntry * adsType) const;
+
+  // Whether rows of this resolution are leaves. Types that contain themselves
+  // have children but no descendants, and are leaves as well.
+  static bool isLeaf(const AdsDatatypeIndex::Resolution & resolution)
+  {
+    return !resolution.declaration || resolution.childCount == 0 || resolution.descendantCount == 0;
+  }
+
+private: // attributes
+  const AdsDatatypeIndex & mTypeIndex;
+  mutable QMutex mMutex;
+  // Resolution::declaration -> layout. Not keyed by hashValue, which targets
+  // without type hashes leave 0 for every type.
+  mutable QHash<const AdsDatatypeEntry *, std::shared_ptr<const AdsLeafLayout>> mLayouts;
+};
+
+template <typename Visit>
+void AdsLeafLayout::forEachLeaf(Visit && visit) const
+{
+  QByteArray path;
+  visitItems(0, mItems.size(), 0, path, visit);
+}
+
+template <typename Visit>
+bool AdsLeafLayout::visitItems(qsizetype first, qsizetype last, uint64_t base, QByteArray & path,
+                               Visit & visit) const
+{
+  auto pathSize = path.size();
+  for (auto i = first; i < last;)
+  {
+    const auto & item = mItems[i];
+    path.append(item.path);
+    if (item.count == 0)
+    {
+      if (!visit(base + item.offset, item, static_cast<const QByteArray &>(path)))
+        return false;
+      ++i;
+    }
+    else
+    {
+      auto elementPathSize = path.size();
+      for (uint32_t element = 0; element < item.count; ++element)
+      {
+        path.append(AdsDatatypeIndex::arrayIndexName(item.array, int(element)));
+        if (!visitItems(i + 1, item.end, base + item.offset + uint64_t(element) * item.size, path, visit))
+          return false;
+        path.truncate(elementPathSize);
+      }
+      i = item.end;
+    }
+    path.truncate(pathSize);
+  }
+  return true;
+}
@@ -0,0 +1,97 @@
+#include "AdsNameTable.h"
+
+#include <QBitArray>
+#include <QDebug>
+
+#include <cstring>
+
+// The table is kept at most half full.
+static uint32_t slotCountFor(uint32_t count)
+{
+  uint32_t slotCount = 2;
+  while (slotCount < 2 * count)
+    slotCount *= 2;
+  return slotCount;
+}
+
+AdsNameTable::AdsNameTable(const QList<uint32_t> & offsets, const QList<uint32_t> & hashes)
+{
+  Q_ASSERT(offsets.size() == hashes.size());
+  uint32_t count = offsets.size();
+  uint32_t slotCount = slotCountFor(count);
+
+  mData = QByteArray((2 + 2 * count + slotCount) * sizeof(uint32_t), '\0');
+  auto data = reinterpret_cast<uint32_t *>(mData.data());
+  data[0] = count;
+  data[1] = slotCount;
+  memcpy(data + 2, offsets.constData(), count * sizeof(uint32_t));
+  memcpy(data + 2 + count, hashes.constData(), count * sizeof(uint32_t));
+
+  // Later records with the same name take precedence, as they are probed first.
+  auto slots = data + 2 + 2 * count;
+  auto mask = slotCount - 1;
+  for (uint32_t ordinal = count; ordinal-- > 0;)
+  {
+    auto iSlot = hashes[ordinal] & mask;
+    while (slots[iSlot] != 0)
+      iSlot = (iSlot + 1) & mask;
+    slots[iSlot] = ordinal + 1;
+  }
+}
+
+// static
+AdsNameTable AdsNameTable::fromData(const QByteArray & data, qsizetype uploadSize)
+{
+  auto invalid = [&data]()
+  {
+    qWarning() << "Invalid name table of" << data.size() << "bytes. Ignored.";
+    return AdsNameTable();
+  };
+
+  if (data.size() < qsizetype(2 * sizeof(uint32_t)))
+    return invalid();
+
+  AdsNameTable table;
+  table.mData = data;
+  auto count = table.count();
+  auto slotCount = table.slotCount();
+  if (slotCount < 2 || (slotCount & (slotCount - 1)) != 0 || slotCount < 2 * count ||
+      data.size() != qsizetype((2 + 2 * qint64(count) + slotCount) * sizeof(uint32_t)))
+    return invalid();
+
+  for (uint32_t ordinal = 0; ordinal < count; ++ordinal)
+  {
+    if (table.offsets()[ordinal] >= uploadSize)
+      return invalid();
+  }
+  // Every record must be in exactly one slot. That leaves empty slots, as
+  // slotCount > count, which find() relies on to stop.
+  QBitArray seen(count);
+  uint32_t occupied = 0;
+  for (uint32_t iSlot = 0; iSlot < slotCount; ++iSlot)
+  {
+    auto slot = table.slots()[iSlot];
+    if (slot == 0)
+      continue;
+    if (slot > count || seen.testBit(slot - 1))
+      return invalid();
+    seen.setBit(slot - 1);
+    ++occupied;
+  }
+  if (occupied != count)
+    return invalid();
+  return table;
+}
+
+// static
+uint32_t AdsNameTable::hash(QByteArrayView name)
+{
+  // FNV-1a
+  uint32_t hash = 2166136261u;
+  for (auto c : name)
+  {
+    hash ^= uint8_t(c);
+    hash *= 16777619u;
+  }
+  return hash;
+}
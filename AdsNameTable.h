@@ -0,0 +1,74 @@
+#pragma once
+
+#include <QByteArray>
+#include <QByteArrayView>
+#include <QList>
+
+#include <cstdint>
+#include <cstring>
+
+// Name index over the records of an ADS upload, kept in a flat, position
+// independent layout, so that it can be stored next to the upload in the
+// symbol cache and used straight from the mapped file:
+//
+//   uint32_t count, slotCount
+//   uint32_t offsets[count]   // offset of each record in the upload
+//   uint32_t hashes[count]    // hash() of each record's name
+//   uint32_t slots[slotCount] // open addressing: record ordinal + 1, 0 if empty
+//
+// Names are hashed as raw (Windows-1252) bytes with a fixed function, so the
+// table stays valid across processes.
+class AdsNameTable
+{
+public: // methods
+  AdsNameTable() = default;
+  AdsNameTable(const QList<uint32_t> & offsets, const QList<uint32_t> & hashes);
+
+  // Takes a serialized table, e.g. a view into a mapped cache file. Returns an
+  // empty table, if data is not consistent with an upload of uploadSize bytes.
+  static AdsNameTable fromData(const QByteArray & data, qsizetype uploadSize);
+
+  static uint32_t hash(QByteArrayView name);
+
+  const QByteArray & data() const { return mData; }
+  bool isEmpty() const { return mData.isEmpty(); }
+
+  uint32_t count() const { return isEmpty() ? 0 : header()[0]; }
+  uint32_t offset(uint32_t ordinal) const { return offsets()[ordinal]; }
+
+  // Returns the ordinal of the last record named name or -1. nameOf(offset)
+  // returns the raw name of the record at offset.
+  template <typename NameOf>
+  qsizetype find(QByteArrayView name, NameOf nameOf) const;
+
+private: // methods
+  const uint32_t * header() const { return reinterpret_cast<const uint32_t *>(mData.constData()); }
+  uint32_t slotCount() const { return header()[1]; }
+  const uint32_t * offsets() const { return header() + 2; }
+  const uint32_t * hashes() const { return offsets() + count(); }
+  const uint32_t * slots() const { return hashes() + count(); }
+
+private: // attributes
+  QByteArray mData;
+};
+
+template <typename NameOf>
+qsizetype AdsNameTable::find(QByteArrayView name, NameOf nameOf) const
+{
+  if (isEmpty())
+    return -1;
+  auto nameHash = hash(name);
+  auto mask = slotCount() - 1;
+  for (auto iSlot = nameHash & mask;; iSlot = (iSlot + 1) & mask)
+  {
+    auto slot = slots()[iSlot];
+    if (slot == 0)
+      return -1;
+    auto ordinal = slot - 1;
+    if (hashes()[ordinal] != nameHash)
+      continue;
+    QByteArrayView candidate = nameOf(offsets()[ordinal]);
+    if (candidate.size() == name.size() && memcmp(candidate.data(), name.data(), name.size()) == 0)
+      return ordinal;
+  }
+}
@@ -0,0 +1,223 @@
+#include "AdsPathIndex.h"
+
+#include "AdsPathSpace.h"
+
+#include <QDebug>
+#include <QMutex>
+#include <QThreadPool>
+#include <QWaitCondition>
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <iterator>
+#include <limits>
+
+static constexpr int HeaderSize = 6;
+// Blocks indexed by one task of the thread pool.
+static constexpr quint64 TaskBlocks = 64;
+
+static uint32_t trigram(const char * text)
+{
+  return uint32_t(uchar(text[0])) << 16 | uint32_t(uchar(text[1])) << 8 | uchar(text[2]);
+}
+
+// Collects (trigram << 32 | block) for the blocks [firstBlock, lastBlock).
+static QList<quint64> indexBlocks(const AdsPathSpace & space, quint64 firstBlock, quint64 lastBlock,
+                                  const std::atomic<bool> & cancelled)
+{
+  QList<quint64> postings;
+  QList<uint32_t> blockTrigrams;
+  quint64 currentBlock = lastBlock;
+  auto endBlock = [&]()
+  {
+    std::sort(blockTrigrams.begin(), blockTrigrams.end());
+    blockTrigrams.erase(std::unique(blockTrigrams.begin(), blockTrigrams.end()), blockTrigrams.end());
+    for (auto t : blockTrigrams)
+      postings << (quint64(t) << 32 | currentBlock);
+    blockTrigrams.clear();
+  };
+
+  space.walk(firstBlock * AdsPathIndex::BlockSize, lastBlock * AdsPathIndex::BlockSize,
+             [&](quint64 ordinal, const AdsDatatypeEntry *, const AdsPathSpace::Cursor & cursor)
+             {
+               // Only the trigrams touching the name of the row itself are new,
+               // the others were added with its parent, unless the parent is
+               // in a block before.
+               auto from = cursor.segmentStart - 2;
+               auto block = ordinal / AdsPathIndex::BlockSize;
+               if (block != currentBlock)
+               {
+                 if (cancelled)
+                   return false;
+                 if (currentBlock != lastBlock)
+                   endBlock();
+                 currentBlock = block;
+                 from = 0;
+               }
+               const auto & path = cursor.foldedPath;
+               for (auto i = std::max<qsizetype>(from, 0); i + 3 <= path.size(); ++i)
+                 blockTrigrams << trigram(path.constData() + i);
+               return true;
+             });
+  if (currentBlock != lastBlock)
+    endBlock();
+  return postings;
+}
+
+// static
+AdsPathIndex AdsPathIndex::build(const AdsPathSpace & space, const std::function<bool()> & isCancelled)
+{
+  auto blockCount = (space.rowCount() + BlockSize - 1) / BlockSize;
+  if (blockCount == 0 || blockCount > std::numeric_limits<uint32_t>::max())
+    return AdsPathIndex();
+
+  QMutex mutex;
+  QWaitCondition taskDone;
+  QList<QList<quint64>> results((blockCount + TaskBlocks - 1) / TaskBlocks);
+  auto pending = results.size();
+  std::atomic<bool> cancelled{false};
+  for (qsizetype iTask = 0; iTask < results.size(); ++iTask)
+  {
+    QThreadPool::globalInstance()->start([&, iTask]()
+               {
+                 auto firstBlock = quint64(iTask) * TaskBlocks;
+                 auto postings = indexBlocks(space, firstBlock, std::min(blockCount, firstBlock + TaskBlocks), cancelled);
+                 QMutexLocker locker(&mutex);
+                 results[iTask] = std::move(postings);
+                 --pending;
+                 taskDone.wakeAll();
+               });
+  }
+  {
+    QMutexLocker locker(&mutex);
+    while (pending > 0)
+    {
+      taskDone.wait(&mutex, 10);
+      if (isCancelled && isCancelled())
+        cancelled = true;
+    }
+  }
+  if (cancelled)
+    return AdsPathIndex();
+
+  QList<quint64> postings;
+  qsizetype postingCount = 0;
+  for (const auto & result : results)
+    postingCount += result.size();
+  if (postingCount > qsizetype(std::numeric_limits<uint32_t>::max()))
+    return AdsPathIndex();
+  postings.reserve(postingCount);
+  for (auto & result : results)
+  {
+    postings << result;
+    result = QList<quint64>();
+  }
+  std::sort(postings.begin(), postings.end());
+
+  QList<uint32_t> trigrams;
+  QList<uint32_t> postingStarts;
+  for (qsizetype i = 0; i < postings.size(); ++i)
+  {
+    auto t = uint32_t(postings[i] >> 32);
+    if (trigrams.isEmpty() || trigrams.last() != t)
+    {
+      trigrams << t;
+      postingStarts << uint32_t(i);
+    }
+  }
+  postingStarts << uint32_t(postings.size());
+
+  AdsPathIndex index;
+  index.mData = QByteArray((HeaderSize + trigrams.size() + postingStarts.size() + postings.size()) * sizeof(uint32_t),
+                           Qt::Uninitialized);
+  auto data = reinterpret_cast<uint32_t *>(index.mData.data());
+  data[0] = BlockSize;
+  data[1] = uint32_t(trigrams.size());
+  data[2] = uint32_t(postings.size());
+  data[3] = uint32_t(space.rowCount());
+  data[4] = uint32_t(space.rowCount() >> 32);
+  data[5] = 0;
+  data += HeaderSize;
+  memcpy(data, trigrams.constData(), trigrams.size() * sizeof(uint32_t));
+  data += trigrams.size();
+  memcpy(data, postingStarts.constData(), postingStarts.size() * sizeof(uint32_t));
+  data += postingStarts.size();
+  for (auto posting : postings)
+    *data++ = uint32_t(posting);
+  return index;
+}
+
+// static
+AdsPathIndex AdsPathIndex::fromData(const QByteArray & data, quint64 rowCount)
+{
+  if (data.isEmpty())
+    return AdsPathIndex(); // none was built
+
+  auto invalid = [&data]()
+  {
+    qWarning() << "Invalid path index of" << data.size() << "bytes. Ignored.";
+    return AdsPathIndex();
+  };
+
+  if (data.size() < qsizetype(HeaderSize * sizeof(uint32_t)))
+    return invalid();
+
+  AdsPathIndex index;
+  index.mData = data;
+  if (index.header()[0] != BlockSize || index.rowCount() != rowCount ||
+      data.size() != qsizetype((HeaderSize + 2 * qint64(index.trigramCount()) + 1 + index.postingCount()) * sizeof(uint32_t)))
+    return invalid();
+
+  auto starts = index.postingStarts();
+  if (starts[0] != 0 || starts[index.trigramCount()] != index.postingCount())
+    return invalid();
+  for (uint32_t i = 0; i < index.trigramCount(); ++i)
+  {
+    if (starts[i] > starts[i + 1])
+      return invalid();
+  }
+  return index;
+}
+
+std::optional<QList<AdsPathIndex::Range>> AdsPathIndex::candidates(QByteArrayView foldedText) const
+{
+  if (isEmpty() || foldedText.size() < 3)
+    return std::nullopt;
+
+  // The posting lists of the trigrams of the text, shortest first.
+  QList<std::pair<const uint32_t *, const uint32_t *>> lists;
+  for (qsizetype i = 0; i + 3 <= foldedText.size(); ++i)
+  {
+    auto t = trigram(foldedText.data() + i);
+    auto end = trigrams() + trigramCount();
+    auto it = std::lower_bound(trigrams(), end, t);
+    if (it == end || *it != t)
+      return QList<Range>(); // no full name has it
+    auto iTrigram = it - trigrams();
+    lists << std::make_pair(postings() + postingStarts()[iTrigram], postings() + postingStarts()[iTrigram + 1]);
+  }
+  std::sort(lists.begin(), lists.end(), [](const auto & a, const auto & b)
+            { return a.second - a.first < b.second - b.first; });
+
+  QList<uint32_t> blocks(lists.first().first, lists.first().second);
+  for (qsizetype iList = 1; iList < lists.size() && !blocks.isEmpty(); ++iList)
+  {
+    QList<uint32_t> intersection;
+    std::set_intersection(blocks.cbegin(), blocks.cend(), lists[iList].first, lists[iList].second,
+                          std::back_inserter(intersection));
+    blocks = std::move(intersection);
+  }
+
+  QList<Range> ranges;
+  for (auto block : blocks)
+  {
+    auto first = quint64(block) * BlockSize;
+    auto last = std::min(first + BlockSize, rowCount());
+    if (!ranges.isEmpty() && ranges.last().last == first)
+      ranges.last().last = last;
+    else
+      ranges << Range{first, last};
+  }
+  return ranges;
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <QByteArray>
+#include <QByteArrayView>
+#include <QList>
+
+#include <cstdint>
+#include <functional>
+#include <optional>
+
+class AdsPathSpace;
+
+// Trigram index over the case-folded full names of all rows of an
+// AdsPathSpace, for substring search. The rows are grouped into blocks of
+// BlockSize consecutive ordinals and each trigram lists the blocks that have
+// a row whose full name contains it. A search then only walks the blocks
+// that have all trigrams of the text.
+//
+// Kept in a flat layout, so that it can be stored in the symbol cache and
+// used straight from the mapped file:
+//
+//   uint32_t blockSize, trigramCount, postingCount, rowCountLow, rowCountHigh, reserved
+//   uint32_t trigrams[trigramCount]                // ascending
+//   uint32_t postingStarts[trigramCount + 1]      // into postings
+//   uint32_t postings[postingCount]               // block numbers, ascending per trigram
+class AdsPathIndex
+{
+public: // types
+  static constexpr uint32_t BlockSize = 256;
+
+  // Rows [first, last)
+  struct Range
+  {
+    quint64 first;
+    quint64 last;
+  };
+
+public: // methods
+  AdsPathIndex() = default;
+
+  // Walks all rows of space on a thread pool. Returns an empty index if
+  // isCancelled() returned true in between.
+  static AdsPathIndex build(const AdsPathSpace & space, const std::function<bool()> & isCancelled = {});
+
+  // Takes a serialized index, e.g. a view into a mapped cache file. Returns an
+  // empty index, if data is not consistent with a path space of rowCount rows.
+  static AdsPathIndex fromData(const QByteArray & data, quint64 rowCount);
+
+  const QByteArray & data() const { return mData; }
+  bool isEmpty() const { return mData.isEmpty(); }
+
+  // The rows whose case-folded full name may contain foldedText, in
+  // ascending order; nullopt if the index cannot tell, i.e. it is empty or
+  // the text is shorter than a trigram.
+  std::optional<QList<Range>> candidates(QByteArrayView foldedText) const;
+
+private: // methods
+  const uint32_t * header() const { return reinterpret_cast<const uint32_t *>(mData.constData()); }
+  uint32_t trigramCount() const { return header()[1]; }
+  uint32_t postingCount() const { return header()[2]; }
+  quint64 rowCount() const { return header()[3] | quint64(header()[4]) << 32; }
+  const uint32_t * trigrams() const { return header() + 6; }
+  const uint32_t * postingStarts() const { return trigrams() + trigramCount(); }
+  const uint32_t * postings() const { return postingStarts() + trigramCount() + 1; }
+
+private: // attributes
+  QByteArray mData;
+};
@@ -0,0 +1,61 @@
+#include "AdsPathSpace.h"
+
+#include "AdsCodec.h"
+#include "AdsSymbolIndex.h"
+
+AdsPathSpace::AdsPathSpace(const AdsSymbolIndex & symbolIndex, const AdsDatatypeIndex & typeIndex)
+    : mSymbolIndex(symbolIndex), mTypeIndex(typeIndex)
+{
+  // Same rows as AdsSymbolModel: symbols of unknown type are left out.
+  mTopLevel.reserve(mSymbolIndex.count());
+  for (qsizetype iSymbol = 0; iSymbol < mSymbolIndex.count(); ++iSymbol)
+  {
+    auto adsType = mTypeIndex.lookupRecord(mSymbolIndex.entry(iSymbol)->rawType());
+    if (!adsType)
+      continue;
+    mTopLevel << TopLevel{adsType, mRowCount, uint32_t(iSymbol)};
+    mRowCount += 1 + mTypeIndex.resolution(adsType).descendantCount;
+  }
+}
+
+const AdsSymbolEntryAccess * AdsPathSpace::topLevelSymbol(int row) const
+{
+  return mSymbolIndex.entry(mTopLevel[row].symbol);
+}
+
+void AdsPathSpace::startSymbol(const TopLevel & topLevel, int row, Cursor & cursor) const
+{
+  auto symbol = mSymbolIndex.entry(topLevel.symbol);
+  auto name = symbol->rawName();
+  cursor.rows = {row};
+  cursor.path = name.toByteArray();
+  cursor.foldedPath = Ads::foldCase(name);
+  cursor.segmentStart = 0;
+  cursor.symbol = symbol;
+  cursor.offset = symbol->iOffs;
+  cursor.size = symbol->size;
+}
+
+// static
+void AdsPathSpace::enter(Cursor & cursor, int row, QByteArrayView separator, QByteArrayView name,
+                         uint32_t offset, uint32_t size)
+{
+  cursor.rows << row;
+  cursor.segmentStart = cursor.path.size();
+  cursor.path.append(separator).append(name);
+  Ads::appendFoldedCase(cursor.foldedPath, separator);
+  Ads::appendFoldedCase(cursor.foldedPath, name);
+  cursor.offset = offset;
+  cursor.size = size;
+}
+
+// static
+void AdsPathSpace::leave(Cursor & cursor, const Mark & mark)
+{
+  cursor.rows.removeLast();
+  cursor.path.truncate(mark.pathSize);
+  cursor.foldedPath.truncate(mark.pathSize);
+  cursor.segmentStart = mark.segmentStart;
+  cursor.offset = mark.offset;
+  cursor.size = mark.size;
+}
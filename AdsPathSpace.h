@@ -0,0 +1,163 @@
+#pragma once
+
+#include "AdsDatatypeEntry.h"
+#include "AdsDatatypeIndex.h"
+
+#include <QByteArray>
+#include <QList>
+
+#include <algorithm>
+#include <cstdint>
+
+class AdsSymbolIndex;
+struct AdsSymbolEntryAccess;
+
+// All rows of the symbol tree, i.e. every symbol with all its members and
+// array elements, numbered in preorder. The numbers (ordinals) are worked out
+// from the row counts of AdsDatatypeIndex::Resolution, so a range of rows can
+// be walked without visiting the rows before it and without creating any
+// model nodes.
+//
+// Immutable after construction, so any number of threads may walk it.
+class AdsPathSpace
+{
+public: // types
+  // The row being visited.
+  struct Cursor
+  {
+    QList<int> rows;        // rows in AdsSymbolModel, from the top level down
+    QByteArray path;        // raw full name
+    QByteArray foldedPath;  // path, case-folded (see Ads::foldCase())
+    qsizetype segmentStart; // where the name of the row itself starts in path
+    const AdsSymbolEntryAccess * symbol; // the top-level symbol
+    uint32_t offset;        // in the index group of symbol
+    uint32_t size;          // of the row, in bytes
+  };
+
+public: // methods
+  // The indexes must outlive the path space.
+  AdsPathSpace(const AdsSymbolIndex & symbolIndex, const AdsDatatypeIndex & typeIndex);
+
+  quint64 rowCount() const { return mRowCount; }
+  const AdsDatatypeIndex & typeIndex() const { return mTypeIndex; }
+
+  // The top-level rows, each of which starts a contiguous run of ordinals.
+  int topLevelCount() const { return int(mTopLevel.size()); }
+  const AdsSymbolEntryAccess * topLevelSymbol(int row) const;
+  quint64 topLevelOrdinal(int row) const
+  {
+    return row < mTopLevel.size() ? mTopLevel[row].firstOrdinal : mRowCount;
+  }
+
+  // Calls visit(ordinal, adsType, cursor) for the rows [first, last) in
+  // preorder. adsType is the record describing the row, as in
+  // AdsDatatypeIndex::Entry::adsType(). Stops early if visit returns false.
+  template <typename Visit>
+  void walk(quint64 first, quint64 last, Visit && visit) const;
+
+private: // types
+  struct TopLevel
+  {
+    const AdsDatatypeEntry * adsType;
+    quint64 firstOrdinal;
+    uint32_t symbol; // ordinal in the symbol index
+  };
+  // What leave() restores of a Cursor.
+  struct Mark
+  {
+    qsizetype pathSize;
+    qsizetype segmentStart;
+    uint32_t offset;
+    uint32_t size;
+  };
+
+private: // methods
+  void startSymbol(const TopLevel & topLevel, int row, Cursor & cursor) const;
+  static void enter(Cursor & cursor, int row, QByteArrayView separator, QByteArrayView name,
+                    uint32_t offset, uint32_t size);
+  static void leave(Cursor & cursor, const Mark & mark);
+
+  template <typename Visit>
+  bool walkSubtree(const AdsDatatypeEntry * adsType, quint64 ordinal, quint64 first, quint64 last,
+                   Cursor & cursor, Visit & visit) const;
+
+private: // attributes
+  const AdsSymbolIndex & mSymbolIndex;
+  const AdsDatatypeIndex & mTypeIndex;
+  QList<TopLevel> mTopLevel;
+  quint64 mRowCount = 0;
+};
+
+template <typename Visit>
+void AdsPathSpace::walk(quint64 first, quint64 last, Visit && visit) const
+{
+  last = std::min(last, mRowCount);
+  if (first >= last)
+    return;
+
+  auto topLevel = std::upper_bound(mTopLevel.cbegin(), mTopLevel.cend(), first,
+                                   [](quint64 ordinal, const TopLevel & topLevel)
+                                   { return ordinal < topLevel.firstOrdinal; }) -
+                  1;
+  Cursor cursor;
+  for (; topLevel != mTopLevel.cend() && topLevel->firstOrdinal < last; ++topLevel)
+  {
+    startSymbol(*topLevel, int(topLevel - mTopLevel.cbegin()), cursor);
+    if (!walkSubtree(topLevel->adsType, topLevel->firstOrdinal, first, last, cursor, visit))
+      return;
+  }
+}
+
+// Walks the rows of the subtree at ordinal that are within [first, last).
+// Returns false if the walk was stopped.
+template <typename Visit>
+bool AdsPathSpace::walkSubtree(const AdsDatatypeEntry * adsType, quint64 ordinal, quint64 first, quint64 last,
+                               Cursor & cursor, Visit & visit) const
+{
+  if (ordinal >= first && !visit(ordinal, adsType, static_cast<const Cursor &>(cursor)))
+    return false;
+
+  const auto & resolution = mTypeIndex.resolution(adsType);
+  auto declaration = resolution.declaration;
+  if (!declaration || resolution.childCount == 0)
+    return true;
+
+  Mark mark{cursor.path.size(), cursor.segmentStart, cursor.offset, cursor.size};
+  auto childOrdinal = ordinal + 1;
+  auto member = declaration->subItems();
+  for (int iMember = 0; iMember < declaration->subItemCount && childOrdinal < last; ++iMember)
+  {
+    auto size = 1 + mTypeIndex.resolution(member).descendantCount;
+    if (childOrdinal + size > first)
+    {
+      enter(cursor, iMember, ".", member->rawName(), mark.offset + member->offs, member->size);
+      auto more = walkSubtree(member, childOrdinal, first, last, cursor, visit);
+      leave(cursor, mark);
+      if (!more)
+        return false;
+    }
+    childOrdinal += size;
+    member = reinterpret_cast<const AdsDatatypeEntry *>(
+        reinterpret_cast<const char *>(member) + member->entryLength);
+  }
+
+  if (resolution.arrayCount == 0 || childOrdinal >= last)
+    return true;
+
+  auto elementSize = 1 + mTypeIndex.resolution(declaration).descendantCount;
+  auto itemSize = declaration->size / uint32_t(resolution.arrayCount);
+  quint64 element = childOrdinal >= first ? 0 : (first - childOrdinal) / elementSize;
+  childOrdinal += element * elementSize;
+  for (; element < quint64(resolution.arrayCount) && childOrdinal < last; ++element)
+  {
+    enter(cursor, declaration->subItemCount + int(element), QByteArrayView(),
+          AdsDatatypeIndex::arrayIndexName(declaration, int(element)),
+          mark.offset + declaration->offs + uint32_t(element) * itemSize, itemSize);
+    auto more = walkSubtree(declaration, childOrdinal, first, last, cursor, visit);
+    leave(cursor, mark);
+    if (!more)
+      return false;
+    childOrdinal += elementSize;
+  }
+  return true;
+}
@@ -0,0 +1,60 @@
+#include "AdsReadPlan.h"
+
+#include <algorithm>
+#include <numeric>
+#include <tuple>
+
+namespace Ads
+{
+ReadPlan::ReadPlan(const QList<ReadRequest> & variables, uint32_t maxGap)
+{
+  QList<qsizetype> order(variables.size());
+  std::iota(order.begin(), order.end(), 0);
+  std::sort(order.begin(), order.end(), [&variables](qsizetype a, qsizetype b)
+            { return std::tie(variables[a].group, variables[a].offset) <
+                     std::tie(variables[b].group, variables[b].offset); });
+
+  mSlices.resize(variables.size());
+  uint64_t blockEnd = 0;
+  for (auto i : order)
+  {
+    const auto & variable = variables[i];
+    auto end = uint64_t(variable.offset) + variable.length;
+    if (mBlocks.isEmpty() || mBlocks.last().group != variable.group ||
+        variable.offset > blockEnd + maxGap)
+    {
+      mBlocks << ReadRequest{variable.group, variable.offset, 0};
+      blockEnd = end;
+    }
+    else
+    {
+      blockEnd = std::max(blockEnd, end);
+    }
+    auto & block = mBlocks.last();
+    block.length = uint32_t(blockEnd - block.offset);
+    mSlices[i] = Slice{mBlocks.size() - 1, variable.offset - block.offset, variable.length};
+  }
+}
+
+QList<ReadResult> ReadPlan::split(const QList<ReadResult> & blockResults) const
+{
+  QList<ReadResult> results;
+  results.reserve(mSlices.size());
+  for (const auto & slice : mSlices)
+  {
+    const auto & blockResult = blockResults[slice.block];
+    if (blockResult.error)
+      results << ReadResult{blockResult.error, QByteArray()};
+    else
+      results << ReadResult{0, blockResult.data.mid(slice.offset, slice.length)};
+  }
+  return results;
+}
+
+QList<ReadResult> ReadPlan::read(const AdsDevice & device) const
+{
+  if (mBlocks.isEmpty())
+    return {};
+  return split(sumRead(device, mBlocks));
+}
+} // namespace Ads
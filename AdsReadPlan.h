@@ -0,0 +1,48 @@
+#pragma once
+
+#include "AdsSumRead.h"
+
+#include <cstdint>
+
+#include <QList>
+
+class AdsDevice;
+
+namespace Ads
+{
+// Reads a set of variables as few contiguous blocks. Variables in the same
+// index group whose address ranges overlap or lie at most maxGap bytes apart,
+// such as the members of a struct or the elements of an array, share a block.
+// The blocks go through sumRead() and are cut back into one result per
+// variable, in the order of the variables.
+//
+// The plan does not change once built, so periodic reads of the same
+// variables build it once and call read() each time.
+class ReadPlan
+{
+public: // methods
+  ReadPlan() = default;
+  explicit ReadPlan(const QList<ReadRequest> & variables, uint32_t maxGap);
+
+  qsizetype variableCount() const { return mSlices.size(); }
+  const QList<ReadRequest> & blocks() const { return mBlocks; }
+
+  // blockResults as returned for blocks(). A variable gets the error of its
+  // block and, without error, its part of the data.
+  QList<ReadResult> split(const QList<ReadResult> & blockResults) const;
+  // Throws AdsException like sumRead().
+  QList<ReadResult> read(const AdsDevice & device) const;
+
+private: // types
+  struct Slice
+  {
+    qsizetype block;
+    uint32_t offset; // in the block
+    uint32_t length;
+  };
+
+private: // attributes
+  QList<ReadRequest> mBlocks;
+  QList<Slice> mSlices; // per variable
+};
+} // namespace Ads
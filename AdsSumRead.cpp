@@ -0,0 +1,114 @@
+#include "AdsSumRead.h"
+#include "AdsDevice.h"
+
+#include <QDebug>
+#include <QtEndian>
+
+#include <algorithm>
+#include <numeric>
+#include <tuple>
+
+namespace
+{
+// TwinCAT refuses sum commands with more sub-commands than this.
+constexpr qsizetype MaxSubRequests = 500;
+
+Ads::ReadResult singleRead(const AdsDevice & device, const Ads::ReadRequest & request)
+{
+  Ads::ReadResult result;
+  result.data = QByteArray(request.length, Qt::Uninitialized);
+  result.error = device.ReadReqEx2(request.group, request.offset, request.length, result.data.data(), nullptr);
+  return result;
+}
+
+// Sends up to MaxSubRequests reads in one ADSIGRP_SUMUP_READ round trip.
+// Falls back to individual reads if the target does not support sum commands.
+QList<Ads::ReadResult> sumReadBatch(const AdsDevice & device, const QList<Ads::ReadRequest> & requests)
+{
+  QList<Ads::ReadResult> results;
+  results.reserve(requests.size());
+
+  if (requests.size() == 1)
+  {
+    results << singleRead(device, requests.first());
+    return results;
+  }
+
+  // The write data is one (group, offset, length) triple per read, the read
+  // data is one error code per read followed by all the values back to back.
+  QByteArray command(requests.size() * 3 * sizeof(uint32_t), Qt::Uninitialized);
+  qsizetype responseSize = requests.size() * sizeof(uint32_t);
+  auto commandData = reinterpret_cast<uint32_t *>(command.data());
+  for (const auto & request : requests)
+  {
+    *commandData++ = qToLittleEndian(request.group);
+    *commandData++ = qToLittleEndian(request.offset);
+    *commandData++ = qToLittleEndian(request.length);
+    responseSize += request.length;
+  }
+
+  QByteArray response(responseSize, Qt::Uninitialized);
+  uint32_t bytesRead = 0;
+  auto error = device.ReadWriteReqEx2(ADSIGRP_SUMUP_READ, requests.size(),
+                                      response.size(), response.data(),
+                                      command.size(), command.constData(),
+                                      &bytesRead);
+  if (error == ADSERR_DEVICE_SRVNOTSUPP || error == ADSERR_DEVICE_INVALIDGRP)
+  {
+    qDebug() << "sumRead: Target does not support sum commands, reading individually.";
+    for (const auto & request : requests)
+      results << singleRead(device, request);
+    return results;
+  }
+  if (error)
+    throw AdsException(error);
+  if (bytesRead != uint32_t(responseSize))
+  {
+    qWarning() << "sumRead: Expected to read" << responseSize << "bytes, but only read" << bytesRead << "bytes.";
+    throw AdsException(ADSERR_DEVICE_INVALIDSIZE);
+  }
+
+  auto errors = reinterpret_cast<const uint32_t *>(response.constData());
+  auto values = response.constData() + requests.size() * sizeof(uint32_t);
+  for (const auto & request : requests)
+  {
+    results << Ads::ReadResult{qFromLittleEndian(*errors++), QByteArray(values, request.length)};
+    values += request.length;
+  }
+  return results;
+}
+} // namespace
+
+namespace Ads
+{
+QList<ReadResult> sumRead(const AdsDevice & device, const QList<ReadRequest> & requests)
+{
+  // Sort the reads by address, so that duplicates are only requested once and
+  // the target is accessed in memory order.
+  QList<qsizetype> order(requests.size());
+  std::iota(order.begin(), order.end(), 0);
+  std::sort(order.begin(), order.end(), [&requests](qsizetype a, qsizetype b)
+            { return std::tie(requests[a].group, requests[a].offset, requests[a].length) <
+                     std::tie(requests[b].group, requests[b].offset, requests[b].length); });
+
+  QList<ReadRequest> uniqueRequests;
+  QList<qsizetype> uniqueIndex(requests.size());
+  for (auto i : order)
+  {
+    if (uniqueRequests.isEmpty() || !(uniqueRequests.last() == requests[i]))
+      uniqueRequests << requests[i];
+    uniqueIndex[i] = uniqueRequests.size() - 1;
+  }
+
+  QList<ReadResult> uniqueResults;
+  uniqueResults.reserve(uniqueRequests.size());
+  for (qsizetype first = 0; first < uniqueRequests.size(); first += MaxSubRequests)
+    uniqueResults << sumReadBatch(device, uniqueRequests.mid(first, MaxSubRequests));
+
+  QList<ReadResult> results;
+  results.reserve(requests.size());
+  for (auto i : uniqueIndex)
+    results << uniqueResults[i];
+  return results;
+}
+} // namespace Ads
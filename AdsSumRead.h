@@ -0,0 +1,35 @@
+#pragma once
+
+#include <cstdint>
+
+#include <QByteArray>
+#include <QList>
+
+class AdsDevice;
+
+namespace Ads
+{
+struct ReadRequest
+{
+  uint32_t group = 0;
+  uint32_t offset = 0;
+  uint32_t length = 0;
+
+  bool operator==(const ReadRequest & other) const
+  {
+    return group == other.group && offset == other.offset && length == other.length;
+  }
+};
+
+struct ReadResult
+{
+  uint32_t error = 0;
+  QByteArray data;
+};
+
+// Reads all requests using ADS sum-read commands (ADSIGRP_SUMUP_READ), so that
+// a whole set of variables costs a single round trip. The results are returned
+// in the order of the requests, each with its own error code.
+// Throws AdsException if the round trip itself fails.
+QList<ReadResult> sumRead(const AdsDevice & device, const QList<ReadRequest> & requests);
+} // namespace Ads
@@ -30,9 +30,9 @@ QJsonObject AdsSymbolEntryAccess::toJson() const
 {
   auto codec = Ads::codec();
   QJsonObject json;
-  json["name"] = codec->toUnicode(name());
-  json["type"] = codec->toUnicode(type());
-  json["comment"] = codec->toUnicode(comment());
+  json["name"] = codec->toUnicode(name(), nameLength);
+  json["type"] = codec->toUnicode(type(), typeLength);
+  json["comment"] = codec->toUnicode(comment(), commentLength);
   json["iGroup"] = int(iGroup);
   json["iOffs"] = int(iOffs);
   json["size"] = int(size);
@@ -44,27 +44,80 @@ QJsonObject AdsSymbolEntryAccess::toJson() const
   return json;
 }
 
+AdsSymbolIndex::AdsSymbolIndex(const QByteArray & symbolUpload, const QByteArray & nameTable,
+                               std::shared_ptr<const void> backing)
+    : mSymbolUpload(symbolUpload), mBacking(std::move(backing))
+{
+  auto table = AdsNameTable::fromData(nameTable, mSymbolUpload.size());
+  if (isValid(table))
+  {
+    mNameTable = table;
+    mBuildPosition = mSymbolUpload.size();
+    return;
+  }
+  qWarning() << "Cached symbol name table does not match the upload. Rebuilding.";
+  build(mSymbolUpload.size());
+}
+
 AdsSymbolIndex::~AdsSymbolIndex()
 {
 }
 
-void AdsSymbolIndex::build()
+bool AdsSymbolIndex::isValid(const AdsNameTable & nameTable) const
 {
-  auto end = mSymbolUpload.constData() + mSymbolUpload.size();
-  auto current =
-      reinterpret_cast<const AdsSymbolEntryAccess *>(mSymbolUpload.constData());
+  if (nameTable.isEmpty())
+    return false;
+  auto size = uint64_t(mSymbolUpload.size());
+  for (uint32_t i = 0; i < nameTable.count(); ++i)
+  {
+    auto offset = nameTable.offset(i);
+    if (offset + sizeof(AdsSymbolEntry) > size)
+      return false;
+    auto symbol = reinterpret_cast<const AdsSymbolEntryAccess *>(mSymbolUpload.constData() + offset);
+    if (offset + uint64_t(symbol->entryLength) > size ||
+        sizeof(AdsSymbolEntry) + uint64_t(symbol->nameLength) + symbol->typeLength + symbol->commentLength + 3 > symbol->entryLength)
+      return false;
+  }
+  return true;
+}
 
-  while (reinterpret_cast<const char *>(current) < end)
+const AdsSymbolEntryAccess * AdsSymbolIndex::lookup(QByteArrayView name) const
+{
+  auto ordinal = mNameTable.find(name,
+                                 [this](uint32_t offset)
+                                 {
+                                   auto symbol = reinterpret_cast<const AdsSymbolEntryAccess *>(mSymbolUpload.constData() + offset);
+                                   return symbol->rawName();
+                                 });
+  return ordinal < 0 ? nullptr : entry(ordinal);
+}
+
+void AdsSymbolIndex::build(qsizetype bytesAvailable)
+{
+  while (mBuildPosition + qsizetype(sizeof(AdsSymbolEntry)) <= bytesAvailable)
   {
-    auto maybeNext = current->maybeNext();
-    if (reinterpret_cast<const char *>(maybeNext) > end)
+    auto current =
+        reinterpret_cast<const AdsSymbolEntryAccess *>(mSymbolUpload.constData() + mBuildPosition);
+    if (Q_UNLIKELY(current->entryLength == 0))
     {
-      qCritical() << "Datatype record extends past end of buffer. Skipped.";
+      qCritical() << "Symbol record of zero length. Skipped the rest.";
+      mBuildPosition = mSymbolUpload.size();
       break;
     }
-    auto currentName = Ads::codec()->toUnicode(current->name());
-    mEntries << current;
-    mNameIndex[currentName] = current;
-    current = maybeNext;
+    if (mBuildPosition + qsizetype(current->entryLength) > bytesAvailable)
+      break;
+    mBuildOffsets << uint32_t(mBuildPosition);
+    mBuildHashes << AdsNameTable::hash(current->rawName());
+    mBuildPosition += current->entryLength;
   }
+
+  if (bytesAvailable < mSymbolUpload.size())
+    return; // more to come
+
+  if (mBuildPosition < mSymbolUpload.size())
+    qCritical() << "Symbol record extends past end of buffer. Skipped.";
+  mBuildPosition = mSymbolUpload.size();
+  mNameTable = AdsNameTable(mBuildOffsets, mBuildHashes);
+  mBuildOffsets.clear();
+  mBuildHashes.clear();
 }
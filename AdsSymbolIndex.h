@@ -1,9 +1,13 @@
 #pragma once
 
 #include "AdsDef.h"
+#include "AdsNameTable.h"
 
 #include <QByteArray>
-#include <QHash>
+#include <QByteArrayView>
+#include <QList>
+
+#include <memory>
 
 class QJsonObject;
 
@@ -15,6 +19,9 @@ public: // methods
   const char * name() const { return reinterpret_cast<const char *>(this + 1); }
   const char * type() const { return name() + nameLength + 1; }
   const char * comment() const { return type() + typeLength + 1; }
+  QByteArrayView rawName() const { return QByteArrayView(name(), nameLength); }
+  QByteArrayView rawType() const { return QByteArrayView(type(), typeLength); }
+  QByteArrayView rawComment() const { return QByteArrayView(comment(), commentLength); }
   const AdsSymbolEntryAccess * maybeNext() const
   {
     return reinterpret_cast<const AdsSymbolEntryAccess *>(reinterpret_cast<const char *>(this) + entryLength);
@@ -25,24 +32,49 @@ public: // methods
 class AdsSymbolIndex
 {
 public: // methods
-  AdsSymbolIndex(const QByteArray & symbolUpload)
-      : mSymbolUpload(symbolUpload)
+  // backing keeps the memory alive, if the upload is a QByteArray::fromRawData()
+  // view, e.g. into a mapped cache file.
+  AdsSymbolIndex(const QByteArray & symbolUpload, std::shared_ptr<const void> backing = nullptr)
+      : mSymbolUpload(symbolUpload), mBacking(std::move(backing))
+  {
+    build(mSymbolUpload.size());
+  }
+  // Reuses a name table built for this upload before (see nameTable()), if it
+  // is valid, instead of walking all records.
+  AdsSymbolIndex(const QByteArray & symbolUpload, const QByteArray & nameTable,
+                 std::shared_ptr<const void> backing = nullptr);
+  // Streaming construction: the upload is written to uploadBuffer() piece by
+  // piece and build() indexes the records that are complete so far.
+  explicit AdsSymbolIndex(qsizetype uploadSize)
+      : mSymbolUpload(uploadSize, Qt::Uninitialized)
   {
-    build();
   }
   AdsSymbolIndex(AdsSymbolIndex &&) = default;
   Q_DISABLE_COPY(AdsSymbolIndex)
 
   ~AdsSymbolIndex();
 
-  const auto & entries() const { return mEntries; }
+  qsizetype count() const { return mNameTable.count(); }
+  const AdsSymbolEntryAccess * entry(qsizetype i) const
+  {
+    return reinterpret_cast<const AdsSymbolEntryAccess *>(mSymbolUpload.constData() + mNameTable.offset(i));
+  }
+  const AdsSymbolEntryAccess * lookup(QByteArrayView name) const;
+
+  const QByteArray & upload() const { return mSymbolUpload; }
+  const AdsNameTable & nameTable() const { return mNameTable; }
+
+  char * uploadBuffer() { return mSymbolUpload.data(); }
+  void build(qsizetype bytesAvailable);
 
 private: // methods
-  void build();
+  bool isValid(const AdsNameTable & nameTable) const;
 
 private: // attributes
   QByteArray mSymbolUpload;
-  QList<const AdsSymbolEntryAccess *> mEntries;
-  QHash<QString, const AdsSymbolEntryAccess *> mNameIndex;
-  // QHash<QString, Entry *> mEntries;
+  std::shared_ptr<const void> mBacking;
+  qsizetype mBuildPosition = 0;
+  QList<uint32_t> mBuildOffsets;
+  QList<uint32_t> mBuildHashes;
+  AdsNameTable mNameTable;
 };
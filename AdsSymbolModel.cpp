@@ -3,45 +3,120 @@
 #include "AdsCodec.h"
 #include "AdsDatatypeEntry.h"
 
+#include <QDataStream>
+#include <QMimeData>
+
 AdsSymbolModel::AdsSymbolModel(AdsDatatypeIndex && typeIndex, AdsSymbolIndex && symbolIndex, QObject * parent)
     : QAbstractItemModel(parent), mTypeIndex(std::move(typeIndex)), mSymbolIndex(std::move(symbolIndex)),
-      mRootNode(new SymbolNode)
+      mPathSpace(mSymbolIndex, mTypeIndex), mLeafLayouts(mTypeIndex), mValueDecoder(mLeafLayouts)
 {
   buildModel();
 }
 
-AdsSymbolModel::~AdsSymbolModel()
+AdsSymbolModel::~AdsSymbolModel() = default;
+
+QString AdsSymbolModel::SymbolNode::fullName() const
 {
-  // Recursively delete all nodes
-  QVector<SymbolNode *> stack = {mRootNode};
-  while (!stack.isEmpty())
-  {
-    SymbolNode * node = stack.takeLast();
-    stack += node->children;
-    delete node;
-  }
+  auto symbolName = symbol->rawName();
+  if (!type->parent())
+    return Ads::toUnicode(symbolName);
+  auto typePath = type->rawFullName();
+  if (typePath.startsWith('['))
+    return Ads::toUnicode(symbolName.toByteArray() + typePath);
+  return Ads::toUnicode(symbolName.toByteArray() + '.' + typePath);
 }
 
 QModelIndex AdsSymbolModel::index(int row, int column,
                                   const QModelIndex & parent) const
 {
+  if (row < 0 || row >= rowCount(parent) || column < 0 ||
+      column >= ColumnCount)
+    return QModelIndex();
+
+  auto node = parent.isValid() ? childNode(uint32_t(parent.internalId()), row) : uint32_t(row);
+  if (Q_UNLIKELY(node == NoNode))
+    return QModelIndex();
+  return createIndex(row, column, quintptr(node));
+}
+
+QModelIndex AdsSymbolModel::indexForRows(const QList<int> & rows, int column) const
+{
+  QModelIndex result;
+  for (qsizetype i = 0; i < rows.size(); ++i)
+    result = index(rows[i], i + 1 < rows.size() ? 0 : column, result);
+  return result;
+}
+
+QList<int> AdsSymbolModel::rowsForIndex(const QModelIndex & index) const
+{
+  QList<int> rows;
+  if (!index.isValid())
+    return rows;
+  for (auto node = uint32_t(index.internalId()); node != NoNode; node = mNodes[node].parent)
+    rows.prepend(int(mNodes[node].row));
+  return rows;
+}
+
+// static
+QMimeData * AdsSymbolModel::mimeDataForRows(const QList<QList<int>> & rowsList)
+{
+  QByteArray encoded;
+  QDataStream stream(&encoded, QIODevice::WriteOnly);
+  stream << rowsList;
+  auto data = new QMimeData;
+  data->setData(RowsMimeType, encoded);
+  return data;
+}
+
+// static
+QList<QList<int>> AdsSymbolModel::rowsFromMimeData(const QMimeData * data)
+{
+  QList<QList<int>> rowsList;
+  if (!data || !data->hasFormat(RowsMimeType))
+    return rowsList;
+  QDataStream stream(data->data(RowsMimeType));
+  stream >> rowsList;
+  return rowsList;
+}
 
-  SymbolNode * parentNode =
-      parent.isValid() ? static_cast<SymbolNode *>(parent.internalPointer())
-                       : mRootNode;
-  if (parentNode->children.isEmpty() && parentNode != mRootNode)
+// Returns the node for the child in row of parent, adding it if necessary.
+uint32_t AdsSymbolModel::childNode(uint32_t parent, int row) const
+{
+  const auto & parentNode = mNodes[parent];
+  auto memberCount = parentNode.type->memberCount(mTypeIndex);
+  if (row < memberCount)
   {
-    for (auto child : parentNode->type->children(mTypeIndex))
+    if (parentNode.firstMember == NoNode)
     {
-      addSymbol(parentNode, parentNode->symbol, child);
+      auto firstMember = uint32_t(mNodes.size());
+      auto symbol = parentNode.symbol;
+      auto type = parentNode.type;
+      mNodes.reserve(mNodes.size() + memberCount);
+      for (int iMember = 0; iMember < memberCount; ++iMember)
+        mNodes << Node{type->child(iMember, mTypeIndex), parent, symbol, NoNode, uint32_t(iMember)};
+      mNodes[parent].firstMember = firstMember;
     }
+    return mNodes[parent].firstMember + row;
   }
 
-  if (row < 0 || row >= parentNode->children.size() || column < 0 ||
-      column >= ColumnCount)
-    return QModelIndex();
+  auto key = quint64(parent) << 32 | uint32_t(row);
+  auto it = mElementNodes.constFind(key);
+  if (it != mElementNodes.constEnd())
+    return *it;
+  auto type = parentNode.type->child(row, mTypeIndex);
+  if (Q_UNLIKELY(!type))
+    return NoNode;
+  auto symbol = parentNode.symbol;
+  auto node = uint32_t(mNodes.size());
+  mNodes << Node{type, parent, symbol, NoNode, uint32_t(row)};
+  mElementNodes.insert(key, node);
+  return node;
+}
 
-  return createIndex(row, column, parentNode->children[row]);
+AdsSymbolModel::SymbolNode AdsSymbolModel::symbolNode(uint32_t node) const
+{
+  const auto & n = mNodes[node];
+  return SymbolNode{mSymbolIndex.entry(n.symbol), n.type};
 }
 
 QModelIndex AdsSymbolModel::parent(const QModelIndex & index) const
@@ -49,29 +124,22 @@ QModelIndex AdsSymbolModel::parent(const QModelIndex & index) const
   if (!index.isValid())
     return QModelIndex();
 
-  SymbolNode * childNode = static_cast<SymbolNode *>(index.internalPointer());
-  SymbolNode * parentNode = childNode->parent;
-
-  if (parentNode == mRootNode)
+  auto parent = mNodes[index.internalId()].parent;
+  if (parent == NoNode)
     return QModelIndex();
 
-  SymbolNode * grandParentNode = parentNode->parent;
-  int row = grandParentNode ? grandParentNode->children.indexOf(parentNode) : 0;
-  return createIndex(row, 0, parentNode);
+  return createIndex(int(mNodes[parent].row), 0, quintptr(parent));
 }
 
 int AdsSymbolModel::rowCount(const QModelIndex & parent) const
 {
-  SymbolNode * parentNode =
-      parent.isValid() ? static_cast<SymbolNode *>(parent.internalPointer())
-                       : mRootNode;
+  if (!parent.isValid())
+    return int(mTopLevelCount);
 
-  if (parent.isValid() && parent.column() != 0)
+  if (parent.column() != 0)
     return 0;
 
-  if (parentNode == mRootNode)
-    return mRootNode->children.size();
-  return parentNode->type->childCount(mTypeIndex);
+  return mNodes[parent.internalId()].type->childCount(mTypeIndex);
 }
 
 int AdsSymbolModel::columnCount(const QModelIndex & parent) const
@@ -85,23 +153,21 @@ QVariant AdsSymbolModel::data(const QModelIndex & index, int role) const
   if (!index.isValid())
     return QVariant();
 
-  SymbolNode * node = static_cast<SymbolNode *>(index.internalPointer());
-  auto codec = Ads::codec();
+  auto node = symbolNode(uint32_t(index.internalId()));
   if (role == Qt::DisplayRole)
   {
     switch (index.column())
     {
       case NameColumn:
-        return node->parent == mRootNode
-                   ? codec->toUnicode(node->symbol->name())
-                   : node->type->name();
+        return !node.type->parent()
+                   ? Ads::toUnicode(node.symbol->rawName())
+                   : node.type->name();
       case TypeColumn:
-        return codec->toUnicode(node->type->adsType()->type());
+        return Ads::toUnicode(node.type->adsType()->rawType());
       case CommentColumn:
-        return codec->toUnicode(node->type->adsType()->comment());
+        return Ads::toUnicode(node.type->adsType()->rawComment());
       case FullNameColumn:
-        return node->parent == mRootNode ? codec->toUnicode(node->symbol->name())
-                                         : codec->toUnicode(node->symbol->name()) + "." + node->type->fullName();
+        return node.fullName();
       default:
         return QVariant();
     }
@@ -111,7 +177,7 @@ QVariant AdsSymbolModel::data(const QModelIndex & index, int role) const
     switch (index.column())
     {
       case FullNameColumn:
-        return QVariant::fromValue<const SymbolNode *>(node);
+        return QVariant::fromValue(node);
     }
   }
   return QVariant();
@@ -138,27 +204,43 @@ QVariant AdsSymbolModel::headerData(int section, Qt::Orientation orientation,
   }
 }
 
+Qt::ItemFlags AdsSymbolModel::flags(const QModelIndex & index) const
+{
+  auto flags = QAbstractItemModel::flags(index);
+  if (index.isValid())
+    flags |= Qt::ItemIsDragEnabled;
+  return flags;
+}
+
+QStringList AdsSymbolModel::mimeTypes() const
+{
+  return {RowsMimeType};
+}
+
+QMimeData * AdsSymbolModel::mimeData(const QModelIndexList & indexes) const
+{
+  QList<QList<int>> rowsList;
+  for (const auto & index : indexes)
+  {
+    if (index.column() == 0)
+      rowsList << rowsForIndex(index);
+  }
+  return mimeDataForRows(rowsList);
+}
+
 void AdsSymbolModel::buildModel()
 {
-  auto codec = Ads::codec();
-  for (const AdsSymbolEntryAccess * symbol : mSymbolIndex.entries())
+  mNodes.reserve(mSymbolIndex.count());
+  for (qsizetype iSymbol = 0; iSymbol < mSymbolIndex.count(); ++iSymbol)
   {
-    auto type = mTypeIndex.lookup(codec->toUnicode(symbol->type()));
+    auto symbol = mSymbolIndex.entry(iSymbol);
+    auto type = mTypeIndex.lookup(symbol->rawType());
     if (!type)
     {
-      qCritical() << "Symbol type not found for symbol:" << codec->toUnicode(symbol->name()) << "Skipping.";
+      qCritical() << "Symbol type not found for symbol:" << Ads::toUnicode(symbol->rawName()) << "Skipping.";
       continue;
     }
-    addSymbol(mRootNode, symbol, type);
+    mNodes << Node{type, NoNode, uint32_t(iSymbol), NoNode, uint32_t(mNodes.size())};
   }
-}
-
-void AdsSymbolModel::addSymbol(SymbolNode * parentNode, const AdsSymbolEntryAccess * symbol, const AdsDatatypeIndex::Entry * type)
-{
-  SymbolNode * newNode = new SymbolNode{
-      parentNode,
-      QList<SymbolNode *>(),
-      symbol,
-      type};
-  parentNode->children.append(newNode);
+  mTopLevelCount = uint32_t(mNodes.size());
 }
@@ -1,11 +1,20 @@
 #pragma once
 
 #include "AdsDatatypeIndex.h"
+#include "AdsLeafLayout.h"
+#include "AdsPathIndex.h"
+#include "AdsPathSpace.h"
 #include "AdsSymbolIndex.h"
+#include "AdsValueDecoder.h"
 
 #include <QAbstractItemModel>
+#include <QHash>
+#include <QList>
+#include <QMetaType>
 #include <QString>
-#include <QVector>
+#include <QStringList>
+
+class QMimeData;
 
 class AdsSymbolModel : public QAbstractItemModel
 {
@@ -20,10 +29,10 @@ public: // types
     FullNameColumn,
     ColumnCount
   };
+  // A symbol or a member or element within it, as returned for Qt::UserRole
+  // of the FullNameColumn.
   struct SymbolNode
   {
-    SymbolNode * parent = nullptr;
-    QList<SymbolNode *> children;
     const AdsSymbolEntryAccess * symbol = nullptr;
     const AdsDatatypeIndex::Entry * type = nullptr;
     uint32_t group() const
@@ -34,7 +43,10 @@ public: // types
     {
       return (symbol ? symbol->iOffs : 0) + (type ? type->offset() : 0);
     }
+    QString fullName() const;
   };
+  // Dragged rows, each as the list of rows from the top level down
+  static constexpr const char * RowsMimeType = "application/x-ads-symbol-rows";
 
 public: // methods
   explicit AdsSymbolModel(AdsDatatypeIndex && typeIndex, AdsSymbolIndex && symbolIndex,
@@ -45,8 +57,23 @@ public: // methods
   const AdsDatatypeIndex & typeIndex() const { return mTypeIndex; }
   const AdsSymbolIndex & symbolIndex() const { return mSymbolIndex; }
 
+  // For searching
+  const AdsPathSpace & pathSpace() const { return mPathSpace; }
+  const AdsPathIndex & pathIndex() const { return mPathIndex; }
+  // Not thread-safe; meant to be called before the model is shown.
+  void setPathIndex(AdsPathIndex && pathIndex) { mPathIndex = std::move(pathIndex); }
+
+  // The leaves of each type, for decoding and exporting values
+  const AdsLeafLayouts & leafLayouts() const { return mLeafLayouts; }
+  const AdsValueDecoder & valueDecoder() const { return mValueDecoder; }
+
   QModelIndex index(int row, int column,
                     const QModelIndex & parent = QModelIndex()) const override;
+  // The row reached by following rows from the top level down.
+  QModelIndex indexForRows(const QList<int> & rows, int column = 0) const;
+  QList<int> rowsForIndex(const QModelIndex & index) const;
+  static QMimeData * mimeDataForRows(const QList<QList<int>> & rowsList);
+  static QList<QList<int>> rowsFromMimeData(const QMimeData * data);
   QModelIndex parent(const QModelIndex & index) const override;
   int rowCount(const QModelIndex & parent = QModelIndex()) const override;
   int columnCount(const QModelIndex & parent = QModelIndex()) const override;
@@ -54,13 +81,41 @@ public: // methods
                 int role = Qt::DisplayRole) const override;
   QVariant headerData(int section, Qt::Orientation orientation,
                       int role = Qt::DisplayRole) const override;
+  Qt::ItemFlags flags(const QModelIndex & index) const override;
+  QStringList mimeTypes() const override;
+  QMimeData * mimeData(const QModelIndexList & indexes) const override;
+
+private: // types
+  // A row of the tree. Nodes live in mNodes and refer to each other by
+  // position, which is also their QModelIndex::internalId(). The top-level
+  // symbols come first, in row order. The members of a node are added
+  // together when the first one is asked for; array elements one by one.
+  struct Node
+  {
+    const AdsDatatypeIndex::Entry * type;
+    uint32_t parent;      // NoNode for top-level symbols
+    uint32_t symbol;      // ordinal in mSymbolIndex
+    uint32_t firstMember; // NoNode until the members are added
+    uint32_t row;         // within the parent, so parent() needs no search
+  };
+  static constexpr uint32_t NoNode = ~0u;
 
 private: // methods
   void buildModel();
-  static void addSymbol(SymbolNode * parentNode, const AdsSymbolEntryAccess * symbol, const AdsDatatypeIndex::Entry * type = nullptr);
+  uint32_t childNode(uint32_t parent, int row) const;
+  SymbolNode symbolNode(uint32_t node) const;
 
 private: // attributes
   AdsDatatypeIndex mTypeIndex;
   AdsSymbolIndex mSymbolIndex;
-  mutable SymbolNode * mRootNode;
+  AdsPathSpace mPathSpace; // refers to the indexes above
+  AdsPathIndex mPathIndex;
+  AdsLeafLayouts mLeafLayouts;   // refers to mTypeIndex
+  AdsValueDecoder mValueDecoder; // refers to mLeafLayouts
+  mutable QList<Node> mNodes;
+  uint32_t mTopLevelCount = 0;
+  // (parent << 32 | row) -> node, for array elements
+  mutable QHash<quint64, uint32_t> mElementNodes;
 };
+
+Q_DECLARE_METATYPE(AdsSymbolModel::SymbolNode)
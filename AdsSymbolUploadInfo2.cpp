@@ -3,6 +3,9 @@
 
 #include <QDebug>
 
+#include <algorithm>
+#include <cstring>
+
 AdsSymbolUploadInfo2 AdsSymbolUploadInfo2::fromDevice(AdsDevice & device)
 {
     AdsSymbolUploadInfo2 info;
@@ -40,3 +43,82 @@ QByteArray AdsSymbolUploadInfo2::uploadDatatypes(AdsDevice & device) const
     }
     return datatypes;
 }
+
+bool AdsSymbolUploadInfo2::uploadSymbols(AdsDevice & device, char * buffer, uint32_t chunkSize,
+                                         const ProgressHandler & onProgress) const
+{
+    return upload(device, ADSIGRP_SYM_UPLOAD, nSymSize, buffer, chunkSize, onProgress);
+}
+
+bool AdsSymbolUploadInfo2::uploadDatatypes(AdsDevice & device, char * buffer, uint32_t chunkSize,
+                                           const ProgressHandler & onProgress) const
+{
+    return upload(device, ADSIGRP_SYM_DT_UPLOAD, nDatatypeSize, buffer, chunkSize, onProgress);
+}
+
+// Number of bytes of the first chunk that are read again with the second one,
+// to verify that the target honours the index offset of the upload.
+static constexpr uint32_t ChunkProbeOverlap = 16;
+
+// static
+bool AdsSymbolUploadInfo2::upload(AdsDevice & device, uint32_t group, uint32_t size,
+                                  char * buffer, uint32_t chunkSize, const ProgressHandler & onProgress)
+{
+    auto uploadAll = [&]()
+    {
+        uint32_t bytesRead = 0;
+        auto error = device.ReadReqEx2(group, 0, size, buffer, &bytesRead);
+        if (error) {
+            throw AdsException(error);
+        }
+        if (bytesRead != size) {
+          qWarning() << "upload: Expected to read" << size << "bytes, but only read" << bytesRead << "bytes.";
+        }
+        return onProgress(bytesRead);
+    };
+
+    if (chunkSize <= ChunkProbeOverlap || chunkSize >= size) {
+        return uploadAll();
+    }
+
+    uint32_t bytesRead = 0;
+    auto error = device.ReadReqEx2(group, 0, chunkSize, buffer, &bytesRead);
+    if (error || bytesRead != chunkSize) {
+        qDebug() << "upload: Chunked upload of group" << Qt::hex << group << "refused, uploading in one piece.";
+        return uploadAll();
+    }
+    if (!onProgress(chunkSize)) {
+        return false;
+    }
+
+    auto received = chunkSize;
+    bool offsetVerified = false;
+    while (received < size) {
+        auto length = std::min(chunkSize, size - received);
+        if (!offsetVerified) {
+            auto probe = QByteArray(ChunkProbeOverlap + length, Qt::Uninitialized);
+            error = device.ReadReqEx2(group, received - ChunkProbeOverlap, probe.size(), probe.data(), &bytesRead);
+            if (error || bytesRead != uint32_t(probe.size())
+                || memcmp(probe.constData(), buffer + received - ChunkProbeOverlap, ChunkProbeOverlap) != 0) {
+                qDebug() << "upload: Target ignores the offset of group" << Qt::hex << group << ", uploading in one piece.";
+                return uploadAll();
+            }
+            memcpy(buffer + received, probe.constData() + ChunkProbeOverlap, length);
+            offsetVerified = true;
+        } else {
+            error = device.ReadReqEx2(group, received, length, buffer + received, &bytesRead);
+            if (error) {
+                throw AdsException(error);
+            }
+            if (bytesRead != length) {
+                qWarning() << "upload: Expected to read" << length << "bytes at" << received << ", but only read" << bytesRead << "bytes.";
+                throw AdsException(ADSERR_DEVICE_INVALIDSIZE);
+            }
+        }
+        received += length;
+        if (!onProgress(received)) {
+            return false;
+        }
+    }
+    return true;
+}
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <cstdint>
+#include <functional>
 #include <memory>
 
 #include <QByteArray>
@@ -15,9 +16,26 @@ struct AdsSymbolUploadInfo2
   uint32_t nMaxDynSymbols = 0;
   uint32_t nUsedDynSymbols = 0;
 
+  // Called with the number of bytes of an upload that have arrived so far.
+  // Return false to abort the upload.
+  using ProgressHandler = std::function<bool(uint32_t bytesAvailable)>;
+
   static AdsSymbolUploadInfo2 fromDevice(class AdsDevice & device);
 
   QByteArray uploadSymbols(class AdsDevice & device) const;
   QByteArray uploadDatatypes(class AdsDevice & device) const;
+
+  // Upload into buffer (of nSymSize or nDatatypeSize bytes) in chunks of
+  // chunkSize bytes, if the target supports offset-based upload, and report
+  // each chunk to onProgress. A chunkSize of 0 uploads in a single request.
+  // Returns false if onProgress aborted the upload.
+  bool uploadSymbols(class AdsDevice & device, char * buffer, uint32_t chunkSize,
+                     const ProgressHandler & onProgress) const;
+  bool uploadDatatypes(class AdsDevice & device, char * buffer, uint32_t chunkSize,
+                       const ProgressHandler & onProgress) const;
+
+private:
+  static bool upload(class AdsDevice & device, uint32_t group, uint32_t size,
+                     char * buffer, uint32_t chunkSize, const ProgressHandler & onProgress);
 };
 #pragma pack(pop)
@@ -0,0 +1,53 @@
+#include "AdsValue.h"
+
+#include <QString>
+#include <QtEndian>
+
+namespace Ads
+{
+QVariant valueToVariant(const QByteArray & value, AdsDatatypeId type)
+{
+  switch (type)
+  {
+    case AdsDatatypeId::Void:
+      return QVariant();
+    case AdsDatatypeId::Bit:
+      return value.at(0) != 0;
+    case AdsDatatypeId::Int8:
+      return static_cast<int8_t>(value.at(0));
+    case AdsDatatypeId::UInt8:
+      return static_cast<uint8_t>(value.at(0));
+    case AdsDatatypeId::Int16:
+      return qFromLittleEndian<int16_t>(value.data());
+    case AdsDatatypeId::UInt16:
+      return qFromLittleEndian<uint16_t>(value.data());
+    case AdsDatatypeId::Int32:
+      return qFromLittleEndian<int32_t>(value.data());
+    case AdsDatatypeId::UInt32:
+      return qFromLittleEndian<uint32_t>(value.data());
+    case AdsDatatypeId::Int64:
+      return qFromLittleEndian<qint64>(value.data());
+    case AdsDatatypeId::UInt64:
+      return qFromLittleEndian<quint64>(value.data());
+    case AdsDatatypeId::Real32:
+      return qFromLittleEndian<float>(value.data());
+    case AdsDatatypeId::Real64:
+      return qFromLittleEndian<double>(value.data());
+    case AdsDatatypeId::Real80:
+      return QVariant::fromValue(qFromLittleEndian<long double>(value.data()));
+    case AdsDatatypeId::String:
+      return QString::fromUtf8(value); // or, use Ads::codec()?
+    case AdsDatatypeId::WString:
+      return QString::fromUtf16(
+          reinterpret_cast<const char16_t *>(value.data()),
+          value.size() / sizeof(char16_t));
+    case AdsDatatypeId::BigType:
+      // Handle BigType as a custom type, or return as QByteArray
+      return QString("Unresolved struct, hex dump: %1")
+          .arg(value.toHex());
+    default:
+      break;
+  }
+  return QString("Unknown type %1").arg(int(type)); // Default case
+}
+} // namespace Ads
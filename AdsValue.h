@@ -0,0 +1,13 @@
+#pragma once
+
+#include "AdsDatatypeEntry.h"
+
+#include <QByteArray>
+#include <QVariant>
+
+namespace Ads
+{
+// Decodes a value as read from the target. Types that are no primitive give
+// a hex dump; AdsValueDecoder decodes those.
+QVariant valueToVariant(const QByteArray & value, AdsDatatypeId type);
+} // namespace Ads
@@ -0,0 +1,40 @@
+#include "AdsValueDecoder.h"
+
+#include "AdsCodec.h"
+#include "AdsValue.h"
+
+#include <QStringList>
+
+// Leaves listed by toVariant() before the text is cut short.
+static constexpr int MaxListedLeaves = 64;
+
+AdsValueDecoder::AdsValueDecoder(const AdsLeafLayouts & layouts)
+    : mLayouts(layouts)
+{
+}
+
+// static
+QVariant AdsValueDecoder::leafValue(const QByteArray & value, uint64_t offset, uint32_t size, AdsDatatypeId type)
+{
+  if (Q_UNLIKELY(offset + size > uint64_t(value.size())))
+    return QVariant();
+  return Ads::valueToVariant(QByteArray::fromRawData(value.constData() + offset, size), type);
+}
+
+QVariant AdsValueDecoder::toVariant(const QByteArray & value, const AdsDatatypeEntry * adsType) const
+{
+  auto layout = mLayouts.layout(adsType);
+  if (!layout)
+    return Ads::valueToVariant(value, AdsDatatypeId(adsType->dataType));
+
+  QStringList leaves;
+  layout->forEachLeaf(
+      [&](uint64_t offset, const AdsLeafLayout::Item & leaf, const QByteArray & path)
+      {
+        leaves << QString("%1=%2").arg(Ads::toUnicode(path), leafValue(value, offset, leaf.size, leaf.type).toString());
+        return leaves.size() < MaxListedLeaves;
+      });
+  if (layout->leafCount() > quint64(leaves.size()))
+    leaves << QString("... (%1 more)").arg(layout->leafCount() - leaves.size());
+  return QString("{%1}").arg(leaves.join(", "));
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include "AdsDatatypeEntry.h"
+#include "AdsLeafLayout.h"
+
+#include <QByteArray>
+#include <QVariant>
+
+#include <cstdint>
+
+// Decodes values of any type in the datatype index, structs and arrays
+// included, leaf by leaf along the type's AdsLeafLayout. The layouts are
+// built once per type and shared with the other users of AdsLeafLayouts.
+class AdsValueDecoder
+{
+public: // methods
+  // The layouts must outlive the decoder.
+  explicit AdsValueDecoder(const AdsLeafLayouts & layouts);
+
+  // adsType is the record describing the value, as in
+  // AdsDatatypeIndex::Entry::adsType(). Primitives give their value, structs
+  // and arrays a text listing their leaves.
+  QVariant toVariant(const QByteArray & value, const AdsDatatypeEntry * adsType) const;
+
+  // Calls visit(path, QVariant) for every leaf of the value in preorder, path
+  // being raw and relative to the value, e.g. ".axis[2].position". A
+  // primitive value is a single leaf with an empty path. Stops early if visit
+  // returns false.
+  template <typename Visit>
+  void decode(const QByteArray & value, const AdsDatatypeEntry * adsType, Visit && visit) const;
+
+  static QVariant leafValue(const QByteArray & value, uint64_t offset, uint32_t size, AdsDatatypeId type);
+
+private: // attributes
+  const AdsLeafLayouts & mLayouts;
+};
+
+template <typename Visit>
+void AdsValueDecoder::decode(const QByteArray & value, const AdsDatatypeEntry * adsType, Visit && visit) const
+{
+  auto layout = mLayouts.layout(adsType);
+  if (!layout)
+  {
+    visit(QByteArray(), leafValue(value, 0, adsType->size, AdsDatatypeId(adsType->dataType)));
+    return;
+  }
+  layout->forEachLeaf([&](uint64_t offset, const AdsLeafLayout::Item & leaf, const QByteArray & path)
+                      { return visit(path, leafValue(value, offset, leaf.size, leaf.type)); });
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <QByteArray>
+
+#include <atomic>
+#include <cstdint>
+
+// Hands ADS notification samples from the AdsLib callback thread(s) to the
+// GUI thread without locking. Any number of threads may push(); one thread
+// drains. Pushing prepends to a singly linked list with a compare-and-swap,
+// draining takes the whole list with one exchange and reverses it, so the
+// samples come out in the order they were pushed.
+class NotificationQueue
+{
+public: // types
+  struct Sample
+  {
+    uint32_t key;       // identifies the subscription
+    uint64_t timestamp; // as sent by the target, in 100 ns since 1601
+    QByteArray data;
+    Sample * next = nullptr;
+  };
+
+public: // methods
+  NotificationQueue() = default;
+  Q_DISABLE_COPY(NotificationQueue)
+  ~NotificationQueue() { drain([](const Sample &) {}); }
+
+  // Takes ownership of sample.
+  void push(Sample * sample)
+  {
+    sample->next = mHead.load(std::memory_order_relaxed);
+    while (!mHead.compare_exchange_weak(sample->next, sample, std::memory_order_release,
+                                        std::memory_order_relaxed))
+    {
+    }
+  }
+
+  // Calls visit(const Sample &) for all samples pushed so far, oldest first.
+  template <typename Visit>
+  void drain(Visit && visit)
+  {
+    Sample * reversed = nullptr;
+    for (auto sample = mHead.exchange(nullptr, std::memory_order_acquire); sample;)
+    {
+      auto next = sample->next;
+      sample->next = reversed;
+      reversed = sample;
+      sample = next;
+    }
+    while (reversed)
+    {
+      auto next = reversed->next;
+      visit(static_cast<const Sample &>(*reversed));
+      delete reversed;
+      reversed = next;
+    }
+  }
+
+private: // attributes
+  std::atomic<Sample *> mHead{nullptr};
+};
@@ -0,0 +1,108 @@
+#include "SearchResultModel.h"
+
+#include "AdsCodec.h"
+#include "AdsDatatypeEntry.h"
+#include "AdsSymbolModel.h"
+
+SearchResultModel::SearchResultModel(const AdsSymbolModel * symbolModel, QObject * parent)
+    : QAbstractTableModel(parent), mSymbolModel(symbolModel)
+{
+}
+
+void SearchResultModel::clear()
+{
+  beginResetModel();
+  mHits.clear();
+  endResetModel();
+}
+
+void SearchResultModel::appendHits(const QList<SymbolSearch::Hit> & hits)
+{
+  if (hits.isEmpty())
+    return;
+  beginInsertRows(QModelIndex(), mHits.size(), mHits.size() + hits.size() - 1);
+  mHits << hits;
+  endInsertRows();
+}
+
+QList<quint64> SearchResultModel::ordinals() const
+{
+  QList<quint64> ordinals;
+  ordinals.reserve(mHits.size());
+  for (const auto & hit : mHits)
+    ordinals << hit.ordinal;
+  return ordinals;
+}
+
+QModelIndex SearchResultModel::symbolModelIndex(int row, int column) const
+{
+  if (row < 0 || row >= mHits.size())
+    return QModelIndex();
+  return mSymbolModel->indexForRows(mHits[row].rows, column);
+}
+
+int SearchResultModel::rowCount(const QModelIndex & parent) const
+{
+  return parent.isValid() ? 0 : int(mHits.size());
+}
+
+int SearchResultModel::columnCount(const QModelIndex & parent) const
+{
+  return parent.isValid() ? 0 : AdsSymbolModel::ColumnCount;
+}
+
+QVariant SearchResultModel::data(const QModelIndex & index, int role) const
+{
+  if (!index.isValid())
+    return QVariant();
+
+  const auto & hit = mHits[index.row()];
+  if (role == Qt::DisplayRole)
+  {
+    switch (index.column())
+    {
+      case AdsSymbolModel::NameColumn:
+      case AdsSymbolModel::FullNameColumn:
+        return Ads::toUnicode(hit.fullName);
+      case AdsSymbolModel::TypeColumn:
+        return Ads::toUnicode(hit.adsType->rawType());
+      case AdsSymbolModel::CommentColumn:
+        return Ads::toUnicode(hit.adsType->rawComment());
+      default:
+        return QVariant();
+    }
+  }
+  if (role == Qt::UserRole && index.column() == AdsSymbolModel::FullNameColumn)
+    return mSymbolModel->data(symbolModelIndex(index.row(), AdsSymbolModel::FullNameColumn), Qt::UserRole);
+  return QVariant();
+}
+
+QVariant SearchResultModel::headerData(int section, Qt::Orientation orientation,
+                                       int role) const
+{
+  return mSymbolModel->headerData(section, orientation, role);
+}
+
+Qt::ItemFlags SearchResultModel::flags(const QModelIndex & index) const
+{
+  auto flags = QAbstractTableModel::flags(index);
+  if (index.isValid())
+    flags |= Qt::ItemIsDragEnabled;
+  return flags;
+}
+
+QStringList SearchResultModel::mimeTypes() const
+{
+  return mSymbolModel->mimeTypes();
+}
+
+QMimeData * SearchResultModel::mimeData(const QModelIndexList & indexes) const
+{
+  QList<QList<int>> rowsList;
+  for (const auto & index : indexes)
+  {
+    if (index.column() == 0)
+      rowsList << mHits[index.row()].rows;
+  }
+  return AdsSymbolModel::mimeDataForRows(rowsList);
+}
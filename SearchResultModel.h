@@ -0,0 +1,43 @@
+#pragma once
+
+#include "SymbolSearch.h"
+
+#include <QAbstractTableModel>
+#include <QList>
+
+class AdsSymbolModel;
+
+// The hits of a SymbolSearch as a flat list with the columns of
+// AdsSymbolModel. The name column shows the full name. Qt::UserRole of the
+// FullNameColumn gives the SymbolNode, like AdsSymbolModel does.
+class SearchResultModel : public QAbstractTableModel
+{
+  Q_OBJECT
+
+public: // methods
+  explicit SearchResultModel(const AdsSymbolModel * symbolModel, QObject * parent = nullptr);
+
+  const AdsSymbolModel * symbolModel() const { return mSymbolModel; }
+  void clear();
+  void appendHits(const QList<SymbolSearch::Hit> & hits);
+  // Of the hits, in row order
+  QList<quint64> ordinals() const;
+
+  // The row of hit row in the symbol model.
+  QModelIndex symbolModelIndex(int row, int column = 0) const;
+
+  int rowCount(const QModelIndex & parent = QModelIndex()) const override;
+  int columnCount(const QModelIndex & parent = QModelIndex()) const override;
+  QVariant data(const QModelIndex & index,
+                int role = Qt::DisplayRole) const override;
+  QVariant headerData(int section, Qt::Orientation orientation,
+                      int role = Qt::DisplayRole) const override;
+  // Hits can be dragged like rows of the symbol model.
+  Qt::ItemFlags flags(const QModelIndex & index) const override;
+  QStringList mimeTypes() const override;
+  QMimeData * mimeData(const QModelIndexList & indexes) const override;
+
+private: // attributes
+  const AdsSymbolModel * mSymbolModel = nullptr;
+  QList<SymbolSearch::Hit> mHits;
+};
@@ -0,0 +1,232 @@
+#include "SymbolCache.h"
+
+#include "AdsDevice.h"
+
+#include <QDebug>
+#include <QDir>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QStandardPaths>
+
+#include <cstring>
+
+// Marks the mappable cache format; files of older formats never match and
+// get replaced on the next upload.
+static constexpr quint32 CacheMagic = 0x41445343; // "ADSC"
+static constexpr quint32 CacheFormatVersion = 4;
+static constexpr quint64 SectionAlignment = 64;
+static constexpr int MaxSections = 8;
+
+struct CacheSection
+{
+  quint64 offset;
+  quint64 size;
+};
+
+// Written and mapped as is, in the byte order of the host (as the ADS
+// uploads themselves).
+struct CacheHeader
+{
+  quint32 magic;
+  quint32 formatVersion;
+  quint32 uploadInfo[6];
+  quint32 symbolVersion;
+  quint32 sectionCount;
+  CacheSection sections[MaxSections];
+};
+static_assert(sizeof(CacheHeader) == 10 * sizeof(quint32) + MaxSections * sizeof(CacheSection),
+              "CacheHeader must not contain padding");
+static_assert(SymbolCache::SectionCount <= MaxSections, "Too many cache sections");
+
+static quint64 alignedOffset(quint64 offset)
+{
+  return (offset + SectionAlignment - 1) / SectionAlignment * SectionAlignment;
+}
+
+static void writeStamp(CacheHeader & header, const SymbolCache::Stamp & stamp)
+{
+  header.uploadInfo[0] = stamp.uploadInfo.nSymbols;
+  header.uploadInfo[1] = stamp.uploadInfo.nSymSize;
+  header.uploadInfo[2] = stamp.uploadInfo.nDatatypes;
+  header.uploadInfo[3] = stamp.uploadInfo.nDatatypeSize;
+  header.uploadInfo[4] = stamp.uploadInfo.nMaxDynSymbols;
+  header.uploadInfo[5] = stamp.uploadInfo.nUsedDynSymbols;
+  header.symbolVersion = stamp.symbolVersion;
+}
+
+SymbolCache::Stamp SymbolCache::Stamp::fromDevice(AdsDevice & device)
+{
+  Stamp stamp;
+  stamp.uploadInfo = AdsSymbolUploadInfo2::fromDevice(device);
+  uint32_t bytesRead = 0;
+  auto error = device.ReadReqEx2(ADSIGRP_SYM_VERSION, 0, sizeof(stamp.symbolVersion), &stamp.symbolVersion, &bytesRead);
+  if (error || bytesRead != sizeof(stamp.symbolVersion))
+  {
+    qWarning() << "Failed to read symbol version, error:" << error;
+    stamp.symbolVersion = 0;
+  }
+  return stamp;
+}
+
+bool SymbolCache::Stamp::operator==(const Stamp & other) const
+{
+  return uploadInfo.nSymbols == other.uploadInfo.nSymbols &&
+         uploadInfo.nSymSize == other.uploadInfo.nSymSize &&
+         uploadInfo.nDatatypes == other.uploadInfo.nDatatypes &&
+         uploadInfo.nDatatypeSize == other.uploadInfo.nDatatypeSize &&
+         uploadInfo.nMaxDynSymbols == other.uploadInfo.nMaxDynSymbols &&
+         uploadInfo.nUsedDynSymbols == other.uploadInfo.nUsedDynSymbols &&
+         symbolVersion == other.symbolVersion;
+}
+
+SymbolCache::SymbolCache(const QString & netId)
+    : mFilename(QStandardPaths::writableLocation(QStandardPaths::CacheLocation) +
+                "/symbols/" + netId)
+{
+}
+
+// Only the header is needed to decide whether the cache is still valid.
+static bool readHeader(QFile & file, const SymbolCache::Stamp & stamp, CacheHeader & header)
+{
+  if (file.peek(reinterpret_cast<char *>(&header), sizeof(header)) != sizeof(header) ||
+      header.magic != CacheMagic || header.formatVersion != CacheFormatVersion ||
+      header.sectionCount != SymbolCache::SectionCount)
+  {
+    qDebug() << "Ignoring cache file of unknown format:" << file.fileName();
+    return false;
+  }
+
+  CacheHeader expected = header;
+  writeStamp(expected, stamp);
+  if (memcmp(header.uploadInfo, expected.uploadInfo, sizeof(header.uploadInfo)) != 0 ||
+      header.symbolVersion != expected.symbolVersion)
+  {
+    qDebug() << "Cache file is outdated:" << file.fileName();
+    return false;
+  }
+  return true;
+}
+
+std::shared_ptr<const SymbolCache::Mapping> SymbolCache::load(const Stamp & stamp) const
+{
+  if (!QFile::exists(mFilename))
+    return nullptr;
+
+  auto mapping = std::make_shared<Mapping>();
+  mapping->mFile.setFileName(mFilename);
+  if (!mapping->mFile.open(QIODevice::ReadOnly))
+  {
+    qWarning() << "Failed to open cache file for reading:" << mFilename;
+    return nullptr;
+  }
+
+  CacheHeader header;
+  if (!readHeader(mapping->mFile, stamp, header))
+    return nullptr;
+
+  mapping->mSize = mapping->mFile.size();
+  for (quint32 iSection = 0; iSection < header.sectionCount; ++iSection)
+  {
+    const auto & section = header.sections[iSection];
+    if (section.offset > quint64(mapping->mSize) || section.size > quint64(mapping->mSize) - section.offset)
+    {
+      qWarning() << "Cache file is truncated:" << mFilename;
+      return nullptr;
+    }
+    mapping->mSections[iSection] = {section.offset, section.size};
+  }
+
+  mapping->mData = mapping->mFile.map(0, mapping->mSize);
+  if (!mapping->mData)
+  {
+    qDebug() << "Failed to map cache file, reading it instead:" << mapping->mFile.errorString();
+    mapping->mFallback = mapping->mFile.readAll();
+    if (mapping->mFallback.size() != mapping->mSize)
+    {
+      qWarning() << "Failed to read cache file:" << mFilename;
+      return nullptr;
+    }
+    mapping->mData = reinterpret_cast<const uchar *>(mapping->mFallback.constData());
+  }
+
+  qDebug() << "Loaded symbols and datatypes from cache:" << mFilename;
+  return mapping;
+}
+
+void SymbolCache::save(const Stamp & stamp, const QList<QByteArray> & sections) const
+{
+  Q_ASSERT(sections.size() == SectionCount);
+
+  CacheHeader header;
+  memset(&header, 0, sizeof(header));
+  header.magic = CacheMagic;
+  header.formatVersion = CacheFormatVersion;
+  writeStamp(header, stamp);
+  header.sectionCount = SectionCount;
+  auto offset = alignedOffset(sizeof(header));
+  for (int iSection = 0; iSection < SectionCount; ++iSection)
+  {
+    header.sections[iSection] = CacheSection{offset, quint64(sections[iSection].size())};
+    offset = alignedOffset(offset + sections[iSection].size());
+  }
+
+  QDir::root().mkpath(QFileInfo(mFilename).absolutePath());
+  QSaveFile cacheFile(mFilename);
+  if (!cacheFile.open(QIODevice::WriteOnly))
+  {
+    qWarning() << "Failed to open cache file for writing:" << mFilename;
+    return;
+  }
+
+  bool ok = cacheFile.write(reinterpret_cast<const char *>(&header), sizeof(header)) == sizeof(header);
+  for (int iSection = 0; ok && iSection < SectionCount; ++iSection)
+  {
+    auto padding = qint64(header.sections[iSection].offset) - cacheFile.pos();
+    ok = cacheFile.write(QByteArray(padding, '\0')) == padding &&
+         cacheFile.write(sections[iSection]) == sections[iSection].size();
+  }
+  if (!ok || !cacheFile.commit())
+  {
+    qWarning() << "Failed to write symbols and datatypes to cache:"
+               << cacheFile.errorString();
+  }
+  else
+  {
+    qDebug() << "Symbols and datatypes saved to cache:" << mFilename;
+  }
+}
+
+void SymbolCache::savePathIndex(const Stamp & stamp, const QByteArray & pathIndex) const
+{
+  QFile cacheFile(mFilename);
+  if (!cacheFile.open(QIODevice::ReadWrite))
+  {
+    qWarning() << "Failed to open cache file for writing:" << mFilename;
+    return;
+  }
+  CacheHeader header;
+  if (!readHeader(cacheFile, stamp, header))
+    return;
+
+  // Appended, so that the sections that mappings of the file point into stay
+  // as they are. The header goes last: until then the file still reads as one
+  // without a path index.
+  auto size = quint64(cacheFile.size());
+  auto offset = alignedOffset(size);
+  header.sections[PathIndexSection] = CacheSection{offset, quint64(pathIndex.size())};
+  auto padding = qint64(offset - size);
+  bool ok = cacheFile.seek(qint64(size)) && cacheFile.write(QByteArray(padding, '\0')) == padding &&
+            cacheFile.write(pathIndex) == pathIndex.size() && cacheFile.flush() && cacheFile.seek(0) &&
+            cacheFile.write(reinterpret_cast<const char *>(&header), sizeof(header)) == sizeof(header);
+  if (!ok)
+    qWarning() << "Failed to write search index to cache:" << cacheFile.errorString();
+  else
+    qDebug() << "Search index saved to cache:" << mFilename;
+}
+
+QByteArray SymbolCache::Mapping::section(Section section) const
+{
+  const auto & location = mSections[section];
+  return QByteArray::fromRawData(reinterpret_cast<const char *>(mData) + location.offset,
+                                 location.size);
+}
@@ -0,0 +1,93 @@
+#pragma once
+
+#include "AdsSymbolUploadInfo2.h"
+
+#include <QByteArray>
+#include <QFile>
+#include <QList>
+#include <QString>
+
+#include <cstdint>
+#include <memory>
+
+class AdsDevice;
+
+// Per-target cache of the symbol and datatype uploads. Each cache file is
+// stamped with the upload info and the symbol version of the target at the
+// time of the upload, so that it is only reused while these still match.
+//
+// The file is laid out to be mapped into memory: a fixed header followed by
+// the sections, each aligned to SectionAlignment. Loading hands out views into
+// the mapping, so a cached target is opened without copying and the pages are
+// shared between all browser instances looking at the same target.
+class SymbolCache
+{
+public: // types
+  struct Stamp
+  {
+    AdsSymbolUploadInfo2 uploadInfo;
+    uint8_t symbolVersion = 0;
+
+    // Probes the few bytes that change with every online change or download.
+    static Stamp fromDevice(AdsDevice & device);
+
+    bool operator==(const Stamp & other) const;
+    bool operator!=(const Stamp & other) const { return !(*this == other); }
+  };
+
+  enum Section
+  {
+    SymbolsSection,
+    DatatypesSection,
+    SymbolNamesSection,   // AdsNameTable of the symbols
+    DatatypeNamesSection, // AdsNameTable of the datatypes
+    PathIndexSection,     // AdsPathIndex, empty if none was built
+    SectionCount
+  };
+
+  class Mapping;
+
+public: // methods
+  explicit SymbolCache(const QString & netId);
+
+  const QString & filename() const { return mFilename; }
+
+  // Returns nullptr if there is no cache or it was stamped differently.
+  std::shared_ptr<const Mapping> load(const Stamp & stamp) const;
+  // Stores the sections in the order of Section.
+  void save(const Stamp & stamp, const QList<QByteArray> & sections) const;
+  // Stores the PathIndexSection of a cache file saved before, once the index
+  // is built. Mappings of the file stay valid.
+  void savePathIndex(const Stamp & stamp, const QByteArray & pathIndex) const;
+
+private: // attributes
+  QString mFilename;
+};
+
+class SymbolCache::Mapping
+{
+public: // methods
+  Mapping() = default;
+  Q_DISABLE_COPY(Mapping)
+
+  // A QByteArray::fromRawData() view into the mapping, which is only valid as
+  // long as the mapping is alive.
+  QByteArray section(Section section) const;
+
+private: // types
+  // Bytes from the start of the file
+  struct Extent
+  {
+    quint64 offset = 0;
+    quint64 size = 0;
+  };
+
+private: // attributes
+  friend class SymbolCache;
+  QFile mFile;
+  // As of loading; savePathIndex() may change the header of the file later.
+  Extent mSections[SectionCount];
+  const uchar * mData = nullptr;
+  qint64 mSize = 0;
+  QByteArray mFallback; // file contents, if the file could not be mapped
+};
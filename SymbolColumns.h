@@ -0,0 +1,183 @@
+#pragma once
+
+// The columnar export of the symbol table and the leaf variable table (see
+// SymbolExport::Format::Columns), and a reader for it.
+//
+// The file is meant to be mapped into memory and used as is: a fixed header,
+// then each column of each table as a plain array, then a heap of the
+// NUL-terminated UTF-8 strings the name columns point into. Every column starts
+// at a multiple of Alignment. Numbers are in the byte order of the writing
+// host; the reader rejects files of the other byte order.
+//
+// Plain C++17 without Qt, so that other tools can include this header alone.
+
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+
+namespace SymbolColumns
+{
+constexpr uint32_t Magic = 0x4C4F4341; // "ACOL"
+constexpr uint32_t FormatVersion = 1;
+constexpr uint32_t ByteOrderMark = 0x01020304;
+constexpr uint64_t Alignment = 64;
+
+enum Table : uint32_t
+{
+  SymbolTable, // the symbols
+  LeafTable,   // their members and array elements without children, in tree order
+  TableCount
+};
+
+enum Column : uint32_t
+{
+  NameColumn,     // uint64_t offsets into the heap: name of a symbol, full path of a leaf
+  TypeNameColumn, // uint64_t offsets into the heap
+  GroupColumn,    // uint32_t index group
+  OffsetColumn,   // uint32_t index offset
+  SizeColumn,     // uint32_t bytes
+  DataTypeColumn, // uint32_t AdsDatatypeId
+  FlagsColumn,    // uint32_t ADSSYMBOLFLAG_* of a symbol, ADSDATATYPEFLAG_* of a leaf
+  ColumnCount
+};
+
+constexpr uint64_t columnWidth(uint32_t column)
+{
+  return column <= TypeNameColumn ? sizeof(uint64_t) : sizeof(uint32_t);
+}
+
+// Bytes from the start of the file
+struct Extent
+{
+  uint64_t offset;
+  uint64_t size;
+};
+
+struct TableHeader
+{
+  uint64_t rowCount;
+  Extent columns[ColumnCount];
+};
+
+struct Header
+{
+  uint32_t magic;
+  uint32_t formatVersion;
+  uint32_t byteOrderMark;
+  uint32_t tableCount;
+  Extent heap;
+  TableHeader tables[TableCount];
+};
+static_assert(sizeof(Header) == 4 * sizeof(uint32_t) + sizeof(Extent) + TableCount * sizeof(TableHeader),
+              "SymbolColumns::Header must not contain padding");
+
+// A table of a File. Valid as long as the memory of the file is.
+class TableView
+{
+public: // methods
+  uint64_t rowCount() const { return mRowCount; }
+
+  const char * name(uint64_t row) const { return string(NameColumn, row); }
+  const char * typeName(uint64_t row) const { return string(TypeNameColumn, row); }
+  uint32_t group(uint64_t row) const { return value(GroupColumn, row); }
+  uint32_t offset(uint64_t row) const { return value(OffsetColumn, row); }
+  uint32_t size(uint64_t row) const { return value(SizeColumn, row); }
+  uint32_t dataType(uint64_t row) const { return value(DataTypeColumn, row); }
+  uint32_t flags(uint64_t row) const { return value(FlagsColumn, row); }
+
+  // The whole column, rowCount() values, for scanning it directly.
+  const uint32_t * values(Column column) const
+  {
+    return reinterpret_cast<const uint32_t *>(mColumns[column]);
+  }
+  const uint64_t * stringOffsets(Column column) const
+  {
+    return reinterpret_cast<const uint64_t *>(mColumns[column]);
+  }
+
+private: // methods
+  friend class File;
+
+  uint32_t value(Column column, uint64_t row) const { return values(column)[row]; }
+  // "" for offsets out of the heap, which a valid file does not have.
+  const char * string(Column column, uint64_t row) const
+  {
+    auto offset = stringOffsets(column)[row];
+    return offset < mHeapSize ? mHeap + offset : "";
+  }
+
+private: // attributes
+  uint64_t mRowCount = 0;
+  const char * mColumns[ColumnCount] = {};
+  const char * mHeap = nullptr;
+  uint64_t mHeapSize = 0;
+};
+
+// The tables of a columnar export in memory, e.g. a mapping of the file.
+class File
+{
+public: // methods
+  // Checks the header and the extents, without looking at the rows. data must
+  // be aligned to 8 bytes, which any mapping is. Returns false, with
+  // errorString() telling why, if the data is no valid export.
+  bool open(const void * data, uint64_t size)
+  {
+    mError = nullptr;
+    auto bytes = static_cast<const char *>(data);
+    if (reinterpret_cast<uintptr_t>(bytes) % sizeof(uint64_t) != 0)
+      return fail("data is not aligned");
+    if (size < sizeof(Header))
+      return fail("file too short");
+    std::memcpy(&mHeader, bytes, sizeof(Header));
+    if (mHeader.magic != Magic)
+      return fail("not a columnar symbol export");
+    if (mHeader.byteOrderMark != ByteOrderMark)
+      return fail("written in the other byte order");
+    if (mHeader.formatVersion != FormatVersion || mHeader.tableCount != TableCount)
+      return fail("unsupported format version");
+    if (!isWithin(mHeader.heap, size) || (mHeader.heap.size > 0 && bytes[mHeader.heap.offset + mHeader.heap.size - 1] != 0))
+      return fail("invalid string heap");
+
+    for (uint32_t table = 0; table < TableCount; ++table)
+    {
+      const auto & tableHeader = mHeader.tables[table];
+      auto & view = mTables[table];
+      view.mRowCount = tableHeader.rowCount;
+      view.mHeap = bytes + mHeader.heap.offset;
+      view.mHeapSize = mHeader.heap.size;
+      for (uint32_t column = 0; column < ColumnCount; ++column)
+      {
+        const auto & extent = tableHeader.columns[column];
+        if (!isWithin(extent, size) || extent.offset % Alignment != 0 ||
+            tableHeader.rowCount > extent.size / columnWidth(column) ||
+            extent.size != tableHeader.rowCount * columnWidth(column))
+          return fail("invalid column");
+        view.mColumns[column] = bytes + extent.offset;
+      }
+    }
+    return true;
+  }
+
+  const char * errorString() const { return mError ? mError : ""; }
+  const TableView & table(Table table) const { return mTables[table]; }
+  const TableView & symbols() const { return mTables[SymbolTable]; }
+  const TableView & leaves() const { return mTables[LeafTable]; }
+
+private: // methods
+  bool fail(const char * error)
+  {
+    mError = error;
+    mTables[SymbolTable] = mTables[LeafTable] = TableView();
+    return false;
+  }
+  static bool isWithin(const Extent & extent, uint64_t size)
+  {
+    return extent.offset <= size && extent.size <= size - extent.offset;
+  }
+
+private: // attributes
+  Header mHeader{};
+  TableView mTables[TableCount];
+  const char * mError = nullptr;
+};
+} // namespace SymbolColumns
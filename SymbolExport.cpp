@@ -0,0 +1,435 @@
+#include "SymbolExport.h"
+
+#include "AdsCodec.h"
+#include "AdsDatatypeEntry.h"
+#include "AdsLeafLayout.h"
+#include "AdsSymbolModel.h"
+#include "SymbolColumns.h"
+
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QMutex>
+#include <QSaveFile>
+#include <QThreadPool>
+#include <QWaitCondition>
+
+#include <algorithm>
+#include <utility>
+
+// Rows of the path space per shard of the leaf export. A shard's text is some
+// MB at most, and the thread pool formats two shards per thread ahead of the
+// writer, which bounds the memory use whatever the size of the target.
+static constexpr quint64 ShardRows = 16384;
+// Rows formatted between checks for cancellation.
+static constexpr qsizetype CancelCheckInterval = 1024;
+// How often the writing thread checks for interruption while waiting, in ms.
+static constexpr unsigned long CancelPollInterval = 5;
+
+// Exports run on a pool of their own, so that their shards never queue behind
+// the tasks of an index build, and cancelling only waits for the shards being
+// formatted.
+static QThreadPool & exportPool()
+{
+  static QThreadPool pool;
+  return pool;
+}
+
+// Appends raw (Windows-1252) text as UTF-8, without decoding plain ASCII.
+static void appendUtf8(QByteArray & out, QByteArrayView raw)
+{
+  if (std::all_of(raw.begin(), raw.end(), [](char c) { return uchar(c) < 0x80; }))
+    out.append(raw);
+  else
+    out.append(Ads::toUnicode(raw).toUtf8());
+}
+
+// Appends raw text as a CSV field, quoted if needed, e.g. for "a[1,2]".
+static void appendCsvField(QByteArray & out, QByteArrayView raw)
+{
+  if (!raw.contains(',') && !raw.contains('"') && !raw.contains('\n') && !raw.contains('\r'))
+  {
+    appendUtf8(out, raw);
+    return;
+  }
+  QByteArray field;
+  appendUtf8(field, raw);
+  out.append('"').append(field.replace('"', "\"\"")).append('"');
+}
+
+// Appends raw text as a JSON string.
+static void appendJsonString(QByteArray & out, QByteArrayView raw)
+{
+  QByteArray text;
+  appendUtf8(text, raw);
+  out.append('"');
+  for (auto c : std::as_const(text))
+  {
+    if (c == '"' || c == '\\')
+      out.append('\\').append(c);
+    else if (uchar(c) < 0x20)
+      out.append("\\u00").append(QByteArray::number(int(c), 16).rightJustified(2, '0'));
+    else
+      out.append(c);
+  }
+  out.append('"');
+}
+
+template <typename T>
+static void appendValue(QByteArray & column, T value)
+{
+  column.append(reinterpret_cast<const char *>(&value), sizeof(value));
+}
+
+static quint64 alignedOffset(quint64 offset)
+{
+  return (offset + SymbolColumns::Alignment - 1) / SymbolColumns::Alignment * SymbolColumns::Alignment;
+}
+
+SymbolExport::SymbolExport(const AdsSymbolModel & model, Format format, const QString & fileName,
+                           QObject * parent)
+    : QThread(parent), mModel(model), mFormat(format), mFileName(fileName)
+{
+}
+
+SymbolExport::~SymbolExport()
+{
+  requestInterruption();
+  wait();
+}
+
+void SymbolExport::run()
+{
+  QSaveFile file(mFileName);
+  if (!file.open(QIODevice::WriteOnly))
+  {
+    mErrorString = file.errorString();
+    return;
+  }
+
+  bool complete = false;
+  switch (mFormat)
+  {
+    case Format::SymbolsJson:
+    {
+      const auto & symbols = mModel.symbolIndex();
+      complete = writeJsonArray(file, symbols.count(), [&symbols](qint64 i) { return symbols.entry(i)->toJson(); });
+      break;
+    }
+    case Format::DataTypesJson:
+    {
+      const auto & types = mModel.typeIndex();
+      complete = writeJsonArray(file, types.count(), [&types](qint64 i) { return types.record(i)->toJson(); });
+      break;
+    }
+    case Format::LeavesCsv:
+    case Format::LeavesJsonLines:
+      complete = writeLeaves(file);
+      break;
+    case Format::Columns:
+      complete = writeColumns(file);
+      break;
+  }
+
+  if (!complete)
+  {
+    file.cancelWriting();
+    if (mErrorString.isEmpty())
+      mErrorString = file.error() != QFileDevice::NoError ? file.errorString() : QString("Cancelled.");
+    return;
+  }
+  if (!file.commit())
+    mErrorString = file.errorString();
+}
+
+// Writes "[", then the entries one per line, then "]". Returns false if
+// cancelled or the file could not be written.
+template <typename EntryJson>
+bool SymbolExport::writeJsonArray(QIODevice & device, qint64 count, EntryJson && entryJson)
+{
+  if (device.write("[\n") < 0)
+    return false;
+  for (qint64 i = 0; i < count; ++i)
+  {
+    if (isInterruptionRequested())
+      return false;
+    auto entry = QJsonDocument(entryJson(i)).toJson(QJsonDocument::Compact);
+    entry.prepend("  ");
+    entry.append(i + 1 < count ? ",\n" : "\n");
+    if (device.write(entry) < 0)
+      return false;
+    mEntryCount = i + 1;
+    reportProgress(mEntryCount, count);
+  }
+  return device.write("]\n") >= 0;
+}
+
+bool SymbolExport::writeLeaves(QIODevice & device)
+{
+  if (mFormat == Format::LeavesCsv && device.write("path,group,offset,size,type,dataType\n") < 0)
+    return false;
+  return formatLeaves([&device](FormattedShard & formatted) { return device.write(formatted.text) >= 0; });
+}
+
+// The leaf count fixes where each column goes, so the leaves are written shard
+// by shard in one pass like the other formats: each column of a shard at the
+// position of its first row, its strings to the end of the heap. The header
+// goes last, once the size of the heap is known.
+bool SymbolExport::writeColumns(QFileDevice & file)
+{
+  const auto & pathSpace = mModel.pathSpace();
+  const auto & typeIndex = pathSpace.typeIndex();
+  quint64 leafCount = 0;
+  for (int row = 0; row < pathSpace.topLevelCount(); ++row)
+  {
+    auto layout = mModel.leafLayouts().layout(typeIndex.lookupRecord(pathSpace.topLevelSymbol(row)->rawType()));
+    leafCount += layout ? layout->leafCount() : 1;
+  }
+
+  SymbolColumns::Header header{};
+  header.magic = SymbolColumns::Magic;
+  header.formatVersion = SymbolColumns::FormatVersion;
+  header.byteOrderMark = SymbolColumns::ByteOrderMark;
+  header.tableCount = SymbolColumns::TableCount;
+  auto position = alignedOffset(sizeof(header));
+  auto placeTable = [&position](SymbolColumns::TableHeader & table, quint64 rowCount)
+  {
+    table.rowCount = rowCount;
+    for (uint32_t column = 0; column < SymbolColumns::ColumnCount; ++column)
+    {
+      table.columns[column] = {position, rowCount * SymbolColumns::columnWidth(column)};
+      position = alignedOffset(position + table.columns[column].size);
+    }
+  };
+  placeTable(header.tables[SymbolColumns::SymbolTable], quint64(pathSpace.topLevelCount()));
+  placeTable(header.tables[SymbolColumns::LeafTable], leafCount);
+  header.heap.offset = position;
+
+  auto writeAt = [&file](quint64 offset, const QByteArray & data)
+  { return data.isEmpty() || (file.seek(qint64(offset)) && file.write(data) == data.size()); };
+  quint64 rowsWritten[SymbolColumns::TableCount] = {};
+  auto writeRows = [&](SymbolColumns::Table table, FormattedShard & shard)
+  {
+    if (shard.columns.isEmpty())
+      return true; // no leaves
+    auto rowCount = quint64(shard.columns[SymbolColumns::GroupColumn].size()) / sizeof(uint32_t);
+    if (rowsWritten[table] + rowCount > header.tables[table].rowCount)
+    {
+      mErrorString = "More leaf variables than their layouts have.";
+      return false;
+    }
+    for (auto column : {SymbolColumns::NameColumn, SymbolColumns::TypeNameColumn})
+    {
+      auto offsets = reinterpret_cast<quint64 *>(shard.columns[column].data());
+      for (quint64 row = 0; row < rowCount; ++row)
+        offsets[row] += header.heap.size;
+    }
+    for (uint32_t column = 0; column < SymbolColumns::ColumnCount; ++column)
+    {
+      const auto & extent = header.tables[table].columns[column];
+      if (!writeAt(extent.offset + rowsWritten[table] * SymbolColumns::columnWidth(column), shard.columns[column]))
+        return false;
+    }
+    if (!writeAt(header.heap.offset + header.heap.size, shard.text))
+      return false;
+    header.heap.size += quint64(shard.text.size());
+    rowsWritten[table] += rowCount;
+    return true;
+  };
+
+  FormattedShard symbols;
+  for (int row = 0; row < pathSpace.topLevelCount(); ++row)
+  {
+    auto symbol = pathSpace.topLevelSymbol(row);
+    appendRow(symbols, symbol->rawName(), symbol->rawType(), symbol->iGroup, symbol->iOffs, symbol->size,
+              symbol->dataType, symbol->flags);
+  }
+  if (!writeRows(SymbolColumns::SymbolTable, symbols) ||
+      !formatLeaves([&](FormattedShard & shard) { return writeRows(SymbolColumns::LeafTable, shard); }))
+    return false;
+  if (rowsWritten[SymbolColumns::LeafTable] != leafCount)
+  {
+    mErrorString = QString("Expected %1 leaf variables, but found %2.").arg(leafCount).arg(rowsWritten[SymbolColumns::LeafTable]);
+    return false;
+  }
+  return writeAt(0, QByteArray::fromRawData(reinterpret_cast<const char *>(&header), sizeof(header)));
+}
+
+// Formats the shards in the thread pool and calls write(FormattedShard &) for
+// each in order. Returns false if cancelled or write returned false.
+template <typename Write>
+bool SymbolExport::formatLeaves(Write && write)
+{
+  auto shards = planShards();
+  QMutex mutex;
+  QWaitCondition shardDone;
+  QList<FormattedShard> results(shards.size());
+  QList<bool> done(shards.size(), false);
+  qsizetype pending = 0; // started, but not done yet
+  std::atomic<bool> cancelled{false};
+
+  auto & pool = exportPool();
+  auto startShard = [&](qsizetype iShard)
+  {
+    {
+      QMutexLocker locker(&mutex);
+      ++pending;
+    }
+    pool.start([&, iShard]()
+               {
+                 FormattedShard formatted;
+                 if (!cancelled)
+                   formatted = formatShard(shards[iShard], cancelled);
+                 QMutexLocker locker(&mutex);
+                 results[iShard] = std::move(formatted);
+                 done[iShard] = true;
+                 --pending;
+                 shardDone.wakeAll();
+               });
+  };
+  // Only this many shards are formatted ahead of the one being written.
+  auto window = 2 * qsizetype(std::max(pool.maxThreadCount(), 1));
+  for (qsizetype iShard = 0; iShard < std::min(window, shards.size()); ++iShard)
+    startShard(iShard);
+
+  // Write the shards in order, which is tree order.
+  bool complete = true;
+  auto rowCount = mModel.pathSpace().rowCount();
+  for (qsizetype iShard = 0; iShard < shards.size() && complete; ++iShard)
+  {
+    if (isInterruptionRequested())
+      cancelled = true;
+    FormattedShard formatted;
+    {
+      QMutexLocker locker(&mutex);
+      while (!done[iShard] && !cancelled)
+      {
+        shardDone.wait(&mutex, CancelPollInterval);
+        if (isInterruptionRequested())
+          cancelled = true;
+      }
+      formatted = std::move(results[iShard]);
+    }
+    if (cancelled || !write(formatted))
+    {
+      complete = false;
+      break;
+    }
+    if (iShard + window < shards.size())
+      startShard(iShard + window);
+    mEntryCount += formatted.leafCount;
+    reportProgress(qint64(shards[iShard].last), qint64(rowCount));
+  }
+
+  cancelled = true; // the remaining shards, if any, are of no use any more
+  {
+    // They refer to the locals here.
+    QMutexLocker locker(&mutex);
+    while (pending > 0)
+      shardDone.wait(&mutex);
+  }
+  return complete;
+}
+
+// Cuts the rows into shards of about ShardRows at root symbols. A symbol with
+// more rows is split, as the path space walks any range of rows directly.
+auto SymbolExport::planShards() const -> QList<Shard>
+{
+  const auto & pathSpace = mModel.pathSpace();
+  QList<Shard> shards;
+  quint64 first = 0;
+  for (int row = 0; row < pathSpace.topLevelCount(); ++row)
+  {
+    auto end = pathSpace.topLevelOrdinal(row + 1);
+    if (end - first < ShardRows)
+      continue;
+    for (; end - first >= 2 * ShardRows; first += ShardRows)
+      shards << Shard{first, first + ShardRows};
+    shards << Shard{first, end};
+    first = end;
+  }
+  if (first < pathSpace.rowCount())
+    shards << Shard{first, pathSpace.rowCount()};
+  return shards;
+}
+
+auto SymbolExport::formatShard(const Shard & shard, const std::atomic<bool> & cancelled) const -> FormattedShard
+{
+  const auto & pathSpace = mModel.pathSpace();
+  const auto & typeIndex = pathSpace.typeIndex();
+  FormattedShard formatted;
+  qsizetype visited = 0;
+  pathSpace.walk(shard.first, shard.last,
+                 [&](quint64, const AdsDatatypeEntry * adsType, const AdsPathSpace::Cursor & cursor)
+                 {
+                   if (++visited % CancelCheckInterval == 0 && cancelled)
+                     return false;
+                   if (!AdsLeafLayouts::isLeaf(typeIndex.resolution(adsType)))
+                     return true;
+
+                   // The record of a top-level symbol is that of its type.
+                   auto type = cursor.rows.size() == 1 ? cursor.symbol->rawType() : adsType->rawType();
+                   auto dataType = adsDatatypeIdToString(AdsDatatypeId(adsType->dataType));
+                   auto & text = formatted.text;
+                   if (mFormat == Format::Columns)
+                   {
+                     appendRow(formatted, cursor.path, type, cursor.symbol->iGroup, cursor.offset, cursor.size,
+                               adsType->dataType, adsType->flags);
+                   }
+                   else if (mFormat == Format::LeavesCsv)
+                   {
+                     appendCsvField(text, cursor.path);
+                     text.append(',').append(QByteArray::number(cursor.symbol->iGroup));
+                     text.append(',').append(QByteArray::number(cursor.offset));
+                     text.append(',').append(QByteArray::number(cursor.size));
+                     text.append(',');
+                     appendCsvField(text, type);
+                     text.append(',').append(dataType).append('\n');
+                   }
+                   else
+                   {
+                     text.append("{\"path\":");
+                     appendJsonString(text, cursor.path);
+                     text.append(",\"group\":").append(QByteArray::number(cursor.symbol->iGroup));
+                     text.append(",\"offset\":").append(QByteArray::number(cursor.offset));
+                     text.append(",\"size\":").append(QByteArray::number(cursor.size));
+                     text.append(",\"type\":");
+                     appendJsonString(text, type);
+                     text.append(",\"dataType\":\"").append(dataType).append("\"}\n");
+                   }
+                   ++formatted.leafCount;
+                   return true;
+                 });
+  return formatted;
+}
+
+// Appends a row to the columns of a shard of Format::Columns, and its strings
+// to the shard's heap, which is its text. The string offsets are relative to
+// the shard's heap until writeColumns() moves them.
+// static
+void SymbolExport::appendRow(FormattedShard & shard, QByteArrayView name, QByteArrayView typeName, uint32_t group,
+                             uint32_t offset, uint32_t size, uint32_t dataType, uint32_t flags)
+{
+  auto & columns = shard.columns;
+  if (columns.isEmpty())
+    columns.resize(SymbolColumns::ColumnCount);
+  appendValue(columns[SymbolColumns::NameColumn], quint64(shard.text.size()));
+  appendUtf8(shard.text, name);
+  shard.text.append('\0');
+  appendValue(columns[SymbolColumns::TypeNameColumn], quint64(shard.text.size()));
+  appendUtf8(shard.text, typeName);
+  shard.text.append('\0');
+  appendValue(columns[SymbolColumns::GroupColumn], group);
+  appendValue(columns[SymbolColumns::OffsetColumn], offset);
+  appendValue(columns[SymbolColumns::SizeColumn], size);
+  appendValue(columns[SymbolColumns::DataTypeColumn], dataType);
+  appendValue(columns[SymbolColumns::FlagsColumn], flags);
+}
+
+void SymbolExport::reportProgress(qint64 done, qint64 total)
+{
+  auto percent = total > 0 ? int(done * 100 / total) : 100;
+  if (percent == mPercent)
+    return;
+  mPercent = percent;
+  emit progress(done, total);
+}
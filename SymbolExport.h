@@ -0,0 +1,89 @@
+#pragma once
+
+#include <QByteArray>
+#include <QList>
+#include <QString>
+#include <QThread>
+
+#include <atomic>
+#include <cstdint>
+
+class AdsSymbolModel;
+class QFileDevice;
+class QIODevice;
+
+// Writes a table of a model to a file off the GUI thread. The entries are
+// serialized one at a time straight into the buffered file, so memory use does
+// not grow with the table. The file replaces an existing one only once it is
+// complete. Progress is reported through progress(). The export is cancelled
+// with requestInterruption() or by deleting it.
+//
+// The leaf variables, i.e. the rows of the AdsPathSpace without children, are
+// formatted in parallel. The rows are cut into shards at root symbols, and
+// symbols with many rows are split. A thread pool formats a bounded window of
+// shards ahead while this thread writes them in tree order.
+class SymbolExport : public QThread
+{
+  Q_OBJECT
+
+public: // types
+  enum class Format
+  {
+    SymbolsJson,   // the symbol records, as AdsSymbolEntryAccess::toJson()
+    DataTypesJson, // the datatype records, as AdsDatatypeEntry::toJson()
+    LeavesCsv,     // path,group,offset,size,type,dataType per leaf variable
+    LeavesJsonLines, // the same as one JSON object per line
+    Columns,       // symbols and leaf variables as columns, see SymbolColumns.h
+  };
+
+public: // methods
+  // The model must outlive the export.
+  SymbolExport(const AdsSymbolModel & model, Format format, const QString & fileName,
+               QObject * parent = nullptr);
+  ~SymbolExport() override;
+
+  // Available after finished(): empty if the file was written.
+  const QString & errorString() const { return mErrorString; }
+  qint64 entryCount() const { return mEntryCount; }
+
+signals:
+  void progress(qint64 done, qint64 total);
+
+protected: // methods
+  void run() override;
+
+private: // types
+  // Rows [first, last) of the path space
+  struct Shard
+  {
+    quint64 first;
+    quint64 last;
+  };
+  struct FormattedShard
+  {
+    QByteArray text;           // the lines; for Columns the string heap
+    QList<QByteArray> columns; // for Columns, see SymbolColumns::Column
+    qint64 leafCount = 0;
+  };
+
+private: // methods
+  bool writeLeaves(QIODevice & device);
+  bool writeColumns(QFileDevice & file);
+  template <typename Write>
+  bool formatLeaves(Write && write);
+  QList<Shard> planShards() const;
+  FormattedShard formatShard(const Shard & shard, const std::atomic<bool> & cancelled) const;
+  static void appendRow(FormattedShard & shard, QByteArrayView name, QByteArrayView typeName, uint32_t group,
+                        uint32_t offset, uint32_t size, uint32_t dataType, uint32_t flags);
+  template <typename EntryJson>
+  bool writeJsonArray(QIODevice & device, qint64 count, EntryJson && entryJson);
+  void reportProgress(qint64 done, qint64 total);
+
+private: // attributes
+  const AdsSymbolModel & mModel;
+  Format mFormat;
+  QString mFileName;
+  QString mErrorString;
+  qint64 mEntryCount = 0;
+  int mPercent = -1; // last reported
+};
@@ -0,0 +1,637 @@
+#include "SymbolQuery.h"
+
+#include "AdsCodec.h"
+#include "AdsDatatypeEntry.h"
+#include "AdsDef.h"
+#include "AdsSymbolIndex.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iterator>
+#include <limits>
+#include <utility>
+
+namespace
+{
+struct FieldName
+{
+  const char * name;
+  SymbolQuery::Field field;
+};
+constexpr FieldName FieldNames[] = {
+    {"name", SymbolQuery::NameField},
+    {"type", SymbolQuery::TypeField},
+    {"comment", SymbolQuery::CommentField},
+    {"group", SymbolQuery::GroupField},
+    {"offset", SymbolQuery::OffsetField},
+    {"size", SymbolQuery::SizeField},
+    {"flag", SymbolQuery::FlagField},
+    {"flags", SymbolQuery::FlagField},
+};
+
+// Flags by name, for symbols and for datatype records, as named by
+// AdsSymbolEntryAccess::adsSymbolFlagsToString() and
+// adsDatatypeFlagsToString().
+struct FlagName
+{
+  const char * name;
+  uint32_t symbolFlags;
+  uint32_t datatypeFlags;
+};
+constexpr FlagName FlagNames[] = {
+    {"PERSISTENT", ADSSYMBOLFLAG_PERSISTENT, ADSDATATYPEFLAG_PERSISTENT},
+    {"BITVALUE", ADSSYMBOLFLAG_BITVALUE, ADSDATATYPEFLAG_BITVALUES},
+    {"BITVALUES", ADSSYMBOLFLAG_BITVALUE, ADSDATATYPEFLAG_BITVALUES},
+    {"REFERENCETO", ADSSYMBOLFLAG_REFERENCETO, ADSDATATYPEFLAG_REFERENCETO},
+    {"TYPEGUID", ADSSYMBOLFLAG_TYPEGUID, ADSDATATYPEFLAG_TYPEGUID},
+    {"TCCOMIFACEPTR", ADSSYMBOLFLAG_TCCOMIFACEPTR, ADSDATATYPEFLAG_TCCOMIFACEPTR},
+    {"READONLY", ADSSYMBOLFLAG_READONLY, 0},
+    {"DATATYPE", 0, ADSDATATYPEFLAG_DATATYPE},
+    {"DATAITEM", 0, ADSDATATYPEFLAG_DATAITEM},
+    {"METHODDEREF", 0, ADSDATATYPEFLAG_METHODDEREF},
+    {"OVERSAMPLE", 0, ADSDATATYPEFLAG_OVERSAMPLE},
+    {"PROPITEM", 0, ADSDATATYPEFLAG_PROPITEM},
+    {"COPYMASK", 0, ADSDATATYPEFLAG_COPYMASK},
+    {"METHODINFOS", 0, ADSDATATYPEFLAG_METHODINFOS},
+    {"ATTRIBUTES", 0, ADSDATATYPEFLAG_ATTRIBUTES},
+    {"ENUMINFOS", 0, ADSDATATYPEFLAG_ENUMINFOS},
+    {"ALIGNED", 0, ADSDATATYPEFLAG_ALIGNED},
+    {"STATIC", 0, ADSDATATYPEFLAG_STATIC},
+    {"SPLEVELS", 0, ADSDATATYPEFLAG_SPLEVELS},
+    {"IGNOREPERSIST", 0, ADSDATATYPEFLAG_IGNOREPERSIST},
+    {"ANYSIZEARRAY", 0, ADSDATATYPEFLAG_ANYSIZEARRAY},
+    {"PERSIST_DT", 0, ADSDATATYPEFLAG_PERSIST_DT},
+    {"INITONRESET", 0, ADSDATATYPEFLAG_INITONRESET},
+};
+
+bool isNumeric(SymbolQuery::Field field)
+{
+  return field == SymbolQuery::GroupField || field == SymbolQuery::OffsetField || field == SymbolQuery::SizeField;
+}
+
+bool compareNumber(quint64 value, SymbolQuery::Compare compare, quint64 number)
+{
+  switch (compare)
+  {
+    case SymbolQuery::Equal:
+      return value == number;
+    case SymbolQuery::NotEqual:
+      return value != number;
+    case SymbolQuery::Less:
+      return value < number;
+    case SymbolQuery::LessEqual:
+      return value <= number;
+    case SymbolQuery::Greater:
+      return value > number;
+    case SymbolQuery::GreaterEqual:
+      return value >= number;
+    default:
+      return false;
+  }
+}
+
+// Ranges are ascending and do not touch.
+QList<AdsPathIndex::Range> intersect(const QList<AdsPathIndex::Range> & a, const QList<AdsPathIndex::Range> & b)
+{
+  QList<AdsPathIndex::Range> result;
+  for (auto ia = a.cbegin(), ib = b.cbegin(); ia != a.cend() && ib != b.cend();)
+  {
+    auto first = std::max(ia->first, ib->first);
+    auto last = std::min(ia->last, ib->last);
+    if (first < last)
+      result << AdsPathIndex::Range{first, last};
+    if (ia->last < ib->last)
+      ++ia;
+    else
+      ++ib;
+  }
+  return result;
+}
+
+QList<AdsPathIndex::Range> unite(const QList<AdsPathIndex::Range> & a, const QList<AdsPathIndex::Range> & b)
+{
+  QList<AdsPathIndex::Range> all;
+  std::merge(a.cbegin(), a.cend(), b.cbegin(), b.cend(), std::back_inserter(all),
+             [](const auto & x, const auto & y) { return x.first < y.first; });
+  QList<AdsPathIndex::Range> result;
+  for (const auto & range : all)
+  {
+    if (!result.isEmpty() && result.last().last >= range.first)
+      result.last().last = std::max(result.last().last, range.last);
+    else
+      result << range;
+  }
+  return result;
+}
+} // namespace
+
+// Recursive descent over the search text; see the grammar in SymbolQuery.h.
+class SymbolQuery::Parser
+{
+public: // methods
+  Parser(const QString & text, SymbolQuery & query) : mText(text), mQuery(query) {}
+
+  void parse()
+  {
+    skipSpace();
+    if (atEnd())
+      return; // empty query
+    auto root = parseOr();
+    skipSpace();
+    if (root >= 0 && !atEnd())
+      fail(QString("Unexpected '%1'").arg(mText[mPos]));
+    if (!mQuery.isValid())
+      mQuery.mNodes.clear();
+  }
+
+private: // methods
+  bool atEnd() const { return mPos >= mText.size(); }
+  void skipSpace()
+  {
+    while (!atEnd() && mText[mPos].isSpace())
+      ++mPos;
+  }
+  bool isDelimiter(qsizetype pos) const
+  {
+    return pos >= mText.size() || mText[pos].isSpace() || mText[pos] == '(' || mText[pos] == ')';
+  }
+  // Consumes keyword, if it is the next word.
+  bool keyword(const char * keyword)
+  {
+    auto length = qsizetype(strlen(keyword));
+    if (QStringView(mText).mid(mPos, length) != QLatin1String(keyword) || !isDelimiter(mPos + length))
+      return false;
+    mPos += length;
+    return true;
+  }
+  int fail(const QString & error)
+  {
+    if (mQuery.mError.isEmpty())
+      mQuery.mError = QString("%1 at position %2").arg(error).arg(mPos + 1);
+    return -1;
+  }
+  int add(Node && node)
+  {
+    if (node.kind == AndNode || node.kind == OrNode)
+    {
+      std::stable_sort(node.children.begin(), node.children.end(),
+                       [this](int a, int b) { return mQuery.cost(a) < mQuery.cost(b); });
+    }
+    mQuery.mNodes << std::move(node);
+    return int(mQuery.mNodes.size() - 1);
+  }
+
+  int parseOr()
+  {
+    Node node{OrNode, {}};
+    do
+    {
+      auto child = parseAnd();
+      if (child < 0)
+        return -1;
+      node.children << child;
+      skipSpace();
+    } while (keyword("OR"));
+    return node.children.size() == 1 ? node.children.first() : add(std::move(node));
+  }
+
+  int parseAnd()
+  {
+    Node node{AndNode, {}};
+    for (;;)
+    {
+      auto child = parseUnary();
+      if (child < 0)
+        return -1;
+      node.children << child;
+      skipSpace();
+      if (atEnd() || mText[mPos] == ')')
+        break;
+      auto pos = mPos;
+      if (keyword("OR"))
+      {
+        mPos = pos; // for parseOr()
+        break;
+      }
+      keyword("AND");
+    }
+    return node.children.size() == 1 ? node.children.first() : add(std::move(node));
+  }
+
+  int parseUnary()
+  {
+    skipSpace();
+    if (atEnd())
+      return fail("Missing term");
+    auto negated = keyword("NOT");
+    if (!negated && mText[mPos] == '-' && !isDelimiter(mPos + 1))
+    {
+      ++mPos;
+      negated = true;
+    }
+    if (negated)
+    {
+      auto child = parseUnary();
+      if (child < 0)
+        return -1;
+      return add(Node{NotNode, {child}});
+    }
+    if (mText[mPos] == '(')
+    {
+      ++mPos;
+      skipSpace();
+      auto child = parseOr();
+      skipSpace();
+      if (child < 0)
+        return -1;
+      if (atEnd() || mText[mPos] != ')')
+        return fail("Missing ')'");
+      ++mPos;
+      return child;
+    }
+    if (mText[mPos] == ')')
+      return fail("Unexpected ')'");
+    return parseTerm();
+  }
+
+  int parseTerm()
+  {
+    Node node{TermNode, {}};
+    auto start = mPos;
+    if (!parseField(node))
+      mPos = start; // a plain text
+    if (mQuery.isValid() && parseValue(node))
+      return finishTerm(node);
+    return -1;
+  }
+
+  // Consumes "field:", "field:~", "field<=", ... Returns false if there is none.
+  bool parseField(Node & node)
+  {
+    auto end = mPos;
+    while (end < mText.size() && mText[end].isLetter())
+      ++end;
+    auto name = QStringView(mText).mid(mPos, end - mPos);
+    auto known = std::find_if(std::begin(FieldNames), std::end(FieldNames), [&name](const FieldName & field)
+                              { return name.compare(QLatin1String(field.name), Qt::CaseInsensitive) == 0; });
+    if (known == std::end(FieldNames))
+      return false;
+
+    static const std::pair<const char *, Compare> Operators[] = {
+        {":~", Contains}, {"!=", NotEqual}, {"<=", LessEqual}, {">=", GreaterEqual},
+        {":", Equal},     {"=", Equal},     {"<", Less},       {">", Greater},
+    };
+    for (const auto & [op, compare] : Operators)
+    {
+      if (QStringView(mText).mid(end).startsWith(QLatin1String(op)))
+      {
+        node.field = known->field;
+        node.compare = compare;
+        mPos = end + qsizetype(strlen(op));
+        return true;
+      }
+    }
+    return false;
+  }
+
+  bool parseValue(Node & node)
+  {
+    QString value;
+    if (!atEnd() && mText[mPos] == '"')
+    {
+      auto end = mText.indexOf('"', mPos + 1);
+      if (end < 0)
+      {
+        fail("Missing '\"'");
+        return false;
+      }
+      value = mText.mid(mPos + 1, end - mPos - 1);
+      mPos = end + 1;
+    }
+    else
+    {
+      auto start = mPos;
+      while (!isDelimiter(mPos))
+        ++mPos;
+      value = mText.mid(start, mPos - start);
+      if (value.isEmpty())
+      {
+        fail("Missing value");
+        return false;
+      }
+    }
+    node.text = Ads::foldCase(Ads::codec()->fromUnicode(value));
+    return true;
+  }
+
+  int finishTerm(Node & node)
+  {
+    if (node.field == FlagField)
+    {
+      if (node.compare != Equal)
+        return fail("Flags can only be compared with ':'");
+      auto flag = std::find_if(std::begin(FlagNames), std::end(FlagNames), [&node](const FlagName & flag)
+                               { return node.text.compare(flag.name, Qt::CaseInsensitive) == 0; });
+      if (flag == std::end(FlagNames))
+        return fail(QString("Unknown flag '%1'").arg(Ads::toUnicode(node.text)));
+      node.symbolFlags = flag->symbolFlags;
+      node.datatypeFlags = flag->datatypeFlags;
+    }
+    else if (isNumeric(node.field))
+    {
+      if (node.compare == Contains)
+        return fail("Numbers cannot be compared with ':~'");
+      bool ok = false;
+      node.number = node.text.startsWith("0x") ? node.text.mid(2).toULongLong(&ok, 16) : node.text.toULongLong(&ok, 10);
+      if (!ok)
+        return fail(QString("'%1' is no number").arg(Ads::toUnicode(node.text)));
+    }
+    else if (node.compare != Equal && node.compare != Contains)
+    {
+      return fail("Texts can only be compared with ':' or ':~'");
+    }
+    return add(std::move(node));
+  }
+
+private: // attributes
+  const QString & mText;
+  SymbolQuery & mQuery;
+  qsizetype mPos = 0;
+};
+
+// static
+SymbolQuery SymbolQuery::parse(const QString & text)
+{
+  SymbolQuery query;
+  Parser(text, query).parse();
+  return query;
+}
+
+// Relative cost of matching node against a row.
+int SymbolQuery::cost(int node) const
+{
+  const auto & n = mNodes[node];
+  switch (n.kind)
+  {
+    case AndNode:
+    case OrNode:
+    {
+      int sum = 0;
+      for (auto child : n.children)
+        sum += cost(child);
+      return sum;
+    }
+    case NotNode:
+      return cost(n.children.first());
+    case TermNode:
+      break;
+  }
+  if (isNumeric(n.field) || n.field == FlagField)
+    return 1;
+  return n.compare == Contains ? 4 : 2;
+}
+
+QList<AdsPathIndex::Range> SymbolQuery::candidates(const AdsPathSpace & space, const AdsPathIndex & index) const
+{
+  if (mNodes.isEmpty())
+    return {AdsPathIndex::Range{0, space.rowCount()}};
+
+  auto root = int(mNodes.size() - 1);
+  QList<AdsPathIndex::Range> ranges;
+  for (int row = 0; row < space.topLevelCount(); ++row)
+  {
+    if (mayMatch(root, space.topLevelSymbol(row)) == False)
+      continue;
+    auto first = space.topLevelOrdinal(row);
+    auto last = space.topLevelOrdinal(row + 1);
+    if (!ranges.isEmpty() && ranges.last().last == first)
+      ranges.last().last = last;
+    else
+      ranges << AdsPathIndex::Range{first, last};
+  }
+
+  if (auto fromIndex = indexCandidates(root, index))
+    ranges = intersect(ranges, *fromIndex);
+  return ranges;
+}
+
+bool SymbolQuery::matches(const AdsDatatypeEntry * adsType, const AdsPathSpace::Cursor & cursor) const
+{
+  return mNodes.isEmpty() || matches(int(mNodes.size() - 1), adsType, cursor);
+}
+
+bool SymbolQuery::matches(int node, const AdsDatatypeEntry * adsType, const AdsPathSpace::Cursor & cursor) const
+{
+  const auto & n = mNodes[node];
+  switch (n.kind)
+  {
+    case AndNode:
+      return std::all_of(n.children.cbegin(), n.children.cend(),
+                         [&](int child) { return matches(child, adsType, cursor); });
+    case OrNode:
+      return std::any_of(n.children.cbegin(), n.children.cend(),
+                         [&](int child) { return matches(child, adsType, cursor); });
+    case NotNode:
+      return !matches(n.children.first(), adsType, cursor);
+    case TermNode:
+      break;
+  }
+
+  // Symbols are described by their symbol entry, the rows below by the
+  // datatype records.
+  auto isSymbol = cursor.rows.size() == 1;
+  auto text = [&](QByteArrayView raw)
+  {
+    return n.compare == Equal ? Ads::equalsFoldedCase(raw, n.text) : Ads::containsFoldedCase(raw, n.text);
+  };
+  switch (n.field)
+  {
+    case NameField:
+      return n.compare == Equal ? cursor.foldedPath == n.text : cursor.foldedPath.contains(n.text);
+    case TypeField:
+      return text(isSymbol ? cursor.symbol->rawType() : adsType->rawType());
+    case CommentField:
+      return text(isSymbol ? cursor.symbol->rawComment() : adsType->rawComment());
+    case GroupField:
+      return compareNumber(cursor.symbol->iGroup, n.compare, n.number);
+    case OffsetField:
+      return compareNumber(cursor.offset, n.compare, n.number);
+    case SizeField:
+      return compareNumber(cursor.size, n.compare, n.number);
+    case FlagField:
+      return (isSymbol ? cursor.symbol->flags & n.symbolFlags : adsType->flags & n.datatypeFlags) != 0;
+  }
+  return false;
+}
+
+// Whether all, none or some of the rows of symbol, including itself, match
+// node. Only the index group is the same for all of them; offsets are within
+// the symbol and sizes are at most its size.
+auto SymbolQuery::mayMatch(int node, const AdsSymbolEntryAccess * symbol) const -> Truth
+{
+  const auto & n = mNodes[node];
+  switch (n.kind)
+  {
+    case AndNode:
+    case OrNode:
+    {
+      auto result = n.kind == AndNode ? True : False;
+      for (auto child : n.children)
+      {
+        auto truth = mayMatch(child, symbol);
+        result = n.kind == AndNode ? std::min(result, truth) : std::max(result, truth);
+      }
+      return result;
+    }
+    case NotNode:
+      return Truth(True - mayMatch(n.children.first(), symbol));
+    case TermNode:
+      break;
+  }
+
+  quint64 low = 0;
+  quint64 high = 0;
+  switch (n.field)
+  {
+    case GroupField:
+      low = high = symbol->iGroup;
+      break;
+    case OffsetField:
+      low = symbol->iOffs;
+      high = low + std::max<quint64>(symbol->size, 1) - 1;
+      break;
+    case SizeField:
+      high = symbol->size;
+      break;
+    default:
+      return Unknown;
+  }
+  // All values within [low, high] match if both ends do and the comparison
+  // excludes no value in between; none does if neither end does and the
+  // comparison includes no value in between.
+  auto lowMatches = compareNumber(low, n.compare, n.number);
+  auto highMatches = compareNumber(high, n.compare, n.number);
+  auto numberInside = low < n.number && n.number < high;
+  if (lowMatches && highMatches && !(n.compare == NotEqual && numberInside))
+    return True;
+  if (!lowMatches && !highMatches && !(n.compare == Equal && numberInside))
+    return False;
+  return Unknown;
+}
+
+// The blocks of rows that the trigram index finds for the texts node needs
+// in the full name; nullopt if that does not narrow the rows.
+std::optional<QList<AdsPathIndex::Range>> SymbolQuery::indexCandidates(int node, const AdsPathIndex & index) const
+{
+  const auto & n = mNodes[node];
+  switch (n.kind)
+  {
+    case AndNode:
+    {
+      std::optional<QList<AdsPathIndex::Range>> result;
+      for (auto child : n.children)
+      {
+        if (auto ranges = indexCandidates(child, index))
+          result = result ? intersect(*result, *ranges) : *ranges;
+      }
+      return result;
+    }
+    case OrNode:
+    {
+      QList<AdsPathIndex::Range> result;
+      for (auto child : n.children)
+      {
+        auto ranges = indexCandidates(child, index);
+        if (!ranges)
+          return std::nullopt;
+        result = unite(result, *ranges);
+      }
+      return result;
+    }
+    case NotNode:
+      return std::nullopt;
+    case TermNode:
+      break;
+  }
+  if (n.field != NameField)
+    return std::nullopt;
+  return index.candidates(n.text);
+}
+
+bool SymbolQuery::narrows(const SymbolQuery & previous) const
+{
+  return !mNodes.isEmpty() && !previous.mNodes.isEmpty() &&
+         implies(int(mNodes.size() - 1), previous, int(previous.mNodes.size() - 1));
+}
+
+// Whether every row matching node matches otherNode of other.
+bool SymbolQuery::implies(int node, const SymbolQuery & other, int otherNode) const
+{
+  const auto & n = mNodes[node];
+  const auto & o = other.mNodes[otherNode];
+  auto impliesOther = [&](int child) { return implies(child, other, otherNode); };
+  auto impliedBy = [&](int otherChild) { return implies(node, other, otherChild); };
+
+  if (n.kind == OrNode)
+    return std::all_of(n.children.cbegin(), n.children.cend(), impliesOther);
+  if (o.kind == AndNode)
+    return std::all_of(o.children.cbegin(), o.children.cend(), impliedBy);
+  if (n.kind == AndNode && std::any_of(n.children.cbegin(), n.children.cend(), impliesOther))
+    return true;
+  if (o.kind == OrNode && std::any_of(o.children.cbegin(), o.children.cend(), impliedBy))
+    return true;
+  if (n.kind == NotNode && o.kind == NotNode)
+    return other.implies(o.children.first(), *this, n.children.first());
+  if (n.kind == TermNode && o.kind == TermNode)
+    return implies(n, o);
+  return false;
+}
+
+// static
+bool SymbolQuery::implies(const Node & term, const Node & otherTerm)
+{
+  if (term.field != otherTerm.field)
+    return false;
+  if (term.field == FlagField)
+    return term.symbolFlags == otherTerm.symbolFlags && term.datatypeFlags == otherTerm.datatypeFlags;
+  if (!isNumeric(term.field))
+  {
+    if (otherTerm.compare == Equal)
+      return term.compare == Equal && term.text == otherTerm.text;
+    return term.text.contains(otherTerm.text);
+  }
+
+  // The values term allows lie within [low, high]; all of them must satisfy
+  // otherTerm, which holds if both ends do and otherTerm is monotonous or
+  // excludes no value in between.
+  quint64 low = 0;
+  quint64 high = std::numeric_limits<quint64>::max();
+  switch (term.compare)
+  {
+    case Equal:
+      low = high = term.number;
+      break;
+    case Less:
+      if (term.number == 0)
+        return true; // matches nothing
+      high = term.number - 1;
+      break;
+    case LessEqual:
+      high = term.number;
+      break;
+    case Greater:
+      if (term.number == high)
+        return true;
+      low = term.number + 1;
+      break;
+    case GreaterEqual:
+      low = term.number;
+      break;
+    default:
+      return term.compare == otherTerm.compare && term.number == otherTerm.number;
+  }
+  auto numberInside = low < otherTerm.number && otherTerm.number < high;
+  return compareNumber(low, otherTerm.compare, otherTerm.number) &&
+         compareNumber(high, otherTerm.compare, otherTerm.number) &&
+         !(otherTerm.compare == NotEqual && numberInside);
+}
@@ -0,0 +1,115 @@
+#pragma once
+
+#include "AdsPathIndex.h"
+#include "AdsPathSpace.h"
+
+#include <QByteArray>
+#include <QList>
+#include <QString>
+
+#include <cstdint>
+
+// A parsed search text. Terms are combined with AND (also implied between
+// adjacent terms), OR, NOT (also a leading '-') and parentheses:
+//
+//   motor                   full name contains "motor"
+//   name:MAIN.fbAxis        full name is "MAIN.fbAxis"
+//   type:ST_Axis            declared type is ST_Axis
+//   comment:~"torque limit" comment contains "torque limit"
+//   group:0x4020            index group, also offset and size; compared
+//   size>1024               with : = != < <= > >=
+//   flag:PERSISTENT         symbol flag for symbols, datatype flag below
+//
+// Text compares ignore case; ':' asks for equality and ':~' for a substring.
+//
+// matches() tests the cheap predicates on numbers and flags before any text.
+// candidates() narrows the rows to walk before that: symbols whose index
+// group, offset range or size already rule out a match are skipped with all
+// rows below, and the trigram index gives the blocks that can contain the
+// texts the query needs.
+class SymbolQuery
+{
+public: // types
+  enum Field
+  {
+    NameField,
+    TypeField,
+    CommentField,
+    GroupField,
+    OffsetField,
+    SizeField,
+    FlagField
+  };
+  enum Compare
+  {
+    Equal,
+    NotEqual,
+    Less,
+    LessEqual,
+    Greater,
+    GreaterEqual,
+    Contains
+  };
+
+public: // methods
+  SymbolQuery() = default;
+
+  // Never fails; see isValid().
+  static SymbolQuery parse(const QString & text);
+
+  bool isValid() const { return mError.isEmpty(); }
+  bool isEmpty() const { return mNodes.isEmpty(); } // blank or invalid text
+  const QString & errorString() const { return mError; }
+
+  // The rows that may match, in ascending order.
+  QList<AdsPathIndex::Range> candidates(const AdsPathSpace & space, const AdsPathIndex & index) const;
+
+  // adsType is the record describing the row, as in AdsPathSpace::walk().
+  bool matches(const AdsDatatypeEntry * adsType, const AdsPathSpace::Cursor & cursor) const;
+
+  // Whether every row this query matches is matched by previous, too, as
+  // when a word is typed further or a term is added. Then it suffices to
+  // search the hits of previous. May miss some cases, but never errs.
+  bool narrows(const SymbolQuery & previous) const;
+
+private: // types
+  enum Kind
+  {
+    AndNode,
+    OrNode,
+    NotNode,
+    TermNode
+  };
+  // Nodes live in mNodes and refer to their children by position. Children
+  // are ordered cheapest first.
+  struct Node
+  {
+    Kind kind;
+    QList<int> children;
+    Field field = NameField;
+    Compare compare = Contains;
+    QByteArray text; // case-folded
+    quint64 number = 0;
+    uint32_t symbolFlags = 0;
+    uint32_t datatypeFlags = 0;
+  };
+  enum Truth
+  {
+    False,
+    Unknown,
+    True
+  };
+  class Parser;
+
+private: // methods
+  int cost(int node) const;
+  bool matches(int node, const AdsDatatypeEntry * adsType, const AdsPathSpace::Cursor & cursor) const;
+  Truth mayMatch(int node, const AdsSymbolEntryAccess * symbol) const;
+  std::optional<QList<AdsPathIndex::Range>> indexCandidates(int node, const AdsPathIndex & index) const;
+  bool implies(int node, const SymbolQuery & other, int otherNode) const;
+  static bool implies(const Node & term, const Node & otherTerm);
+
+private: // attributes
+  QList<Node> mNodes; // the root is the last one
+  QString mError;
+};
@@ -0,0 +1,189 @@
+#include "SymbolSearch.h"
+
+#include <QElapsedTimer>
+#include <QMutex>
+#include <QThreadPool>
+#include <QWaitCondition>
+
+#include <algorithm>
+
+// Rows per task. Small enough to keep all workers busy on lopsided programs,
+// large enough to make the scheduling cost negligible.
+static constexpr quint64 TaskSize = 16384;
+// Walking a range costs as much as visiting this many rows, for the descent
+// to its first row.
+static constexpr quint64 RangeCost = 32;
+// Rows visited between checks for interruption.
+static constexpr qsizetype CancelCheckInterval = 1024;
+// How often the collecting thread checks for interruption while waiting, in ms.
+static constexpr unsigned long CancelPollInterval = 5;
+// Hits are reported when this many have been found, or after BatchInterval ms.
+static constexpr qsizetype BatchSize = 512;
+static constexpr qint64 BatchInterval = 50;
+// More hits than this are of no use in a flat list.
+static constexpr qsizetype MaxHits = 100000;
+
+SymbolSearch::SymbolSearch(const AdsPathSpace & pathSpace, const AdsPathIndex & pathIndex,
+                           const SymbolQuery & query, QObject * parent)
+    : QThread(parent), mPathSpace(pathSpace), mPathIndex(pathIndex), mQuery(query)
+{
+}
+
+SymbolSearch::~SymbolSearch()
+{
+  requestInterruption();
+  wait();
+}
+
+void SymbolSearch::refine(const QList<quint64> & ordinals)
+{
+  QList<AdsPathIndex::Range> ranges;
+  for (auto ordinal : ordinals)
+  {
+    if (!ranges.isEmpty() && ranges.last().last == ordinal)
+      ++ranges.last().last;
+    else
+      ranges << AdsPathIndex::Range{ordinal, ordinal + 1};
+  }
+  mRefined = std::move(ranges);
+}
+
+// Searches run on a pool of their own, so that their tasks never queue behind
+// those of an index build or an export, and stopping a search only waits for
+// its own. It is kept, so that a search per typing pause starts no threads.
+static QThreadPool & searchPool()
+{
+  static QThreadPool pool;
+  return pool;
+}
+
+// Splits the rows to search into ranges of at most TaskSize rows and groups
+// them into tasks of about TaskSize rows, counting RangeCost per range.
+void SymbolSearch::plan()
+{
+  auto ranges = mRefined ? *mRefined : mQuery.candidates(mPathSpace, mPathIndex);
+  quint64 taskCost = 0;
+  qsizetype taskFirst = 0;
+  for (const auto & range : ranges)
+  {
+    for (auto first = range.first; first < range.last; first += TaskSize)
+    {
+      auto last = std::min(first + TaskSize, range.last);
+      mRanges << AdsPathIndex::Range{first, last};
+      taskCost += RangeCost + (last - first);
+      if (taskCost >= TaskSize)
+      {
+        mTasks << Task{taskFirst, mRanges.size()};
+        taskFirst = mRanges.size();
+        taskCost = 0;
+      }
+    }
+  }
+  if (taskFirst < mRanges.size())
+    mTasks << Task{taskFirst, mRanges.size()};
+}
+
+QList<SymbolSearch::Hit> SymbolSearch::search(const Task & task) const
+{
+  QList<Hit> hits;
+  qsizetype visited = 0;
+  bool stopped = false;
+  auto visit = [&](quint64 ordinal, const AdsDatatypeEntry * adsType, const AdsPathSpace::Cursor & cursor)
+  {
+    if (++visited % CancelCheckInterval == 0 && (mCancelled || isInterruptionRequested()))
+    {
+      stopped = true;
+      return false;
+    }
+    if (!mQuery.matches(adsType, cursor))
+      return true;
+    // The hits of the tasks before count, too, but are not known here.
+    if (hits.size() == MaxHits)
+    {
+      stopped = true;
+      return false;
+    }
+    hits << Hit{cursor.rows, cursor.path, adsType, ordinal};
+    return true;
+  };
+  for (auto iRange = task.first; iRange < task.last && !stopped; ++iRange)
+    mPathSpace.walk(mRanges[iRange].first, mRanges[iRange].last, visit);
+  return hits;
+}
+
+void SymbolSearch::run()
+{
+  plan();
+
+  QMutex mutex;
+  QWaitCondition taskDone;
+  QList<QList<Hit>> results(mTasks.size());
+  QList<bool> done(mTasks.size(), false);
+  auto pending = mTasks.size();
+
+  auto & pool = searchPool();
+  for (qsizetype iTask = 0; iTask < mTasks.size(); ++iTask)
+  {
+    pool.start([&, iTask]()
+               {
+                 QList<Hit> hits;
+                 if (!mCancelled && !isInterruptionRequested())
+                   hits = search(mTasks[iTask]);
+                 QMutexLocker locker(&mutex);
+                 results[iTask] = std::move(hits);
+                 done[iTask] = true;
+                 --pending;
+                 taskDone.wakeAll();
+               });
+  }
+
+  // Collect the results in task order, which is tree order.
+  QList<Hit> batch;
+  QElapsedTimer batchTimer;
+  batchTimer.start();
+  auto flush = [&]()
+  {
+    if (!batch.isEmpty() && !isInterruptionRequested())
+      emit hitsFound(batch);
+    batch.clear();
+    batchTimer.restart();
+  };
+  for (qsizetype iTask = 0; iTask < mTasks.size() && !mCancelled; ++iTask)
+  {
+    QList<Hit> hits;
+    {
+      QMutexLocker locker(&mutex);
+      while (!done[iTask] && !mCancelled)
+      {
+        taskDone.wait(&mutex, CancelPollInterval);
+        if (isInterruptionRequested())
+          mCancelled = true;
+      }
+      hits = std::move(results[iTask]);
+    }
+    for (auto & hit : hits)
+    {
+      if (mHitCount == MaxHits)
+      {
+        mTruncated = true;
+        mCancelled = true;
+        break;
+      }
+      batch << std::move(hit);
+      ++mHitCount;
+      if (batch.size() >= BatchSize)
+        flush();
+    }
+    if (batchTimer.hasExpired(BatchInterval))
+      flush();
+  }
+
+  mCancelled = true; // the remaining tasks, if any, are of no use any more
+  {
+    // They refer to the locals here.
+    QMutexLocker locker(&mutex);
+    while (pending > 0)
+      taskDone.wait(&mutex);
+  }
+  flush();
+}
@@ -0,0 +1,83 @@
+#pragma once
+
+#include "SymbolQuery.h"
+
+#include <QByteArray>
+#include <QList>
+#include <QMetaType>
+#include <QThread>
+
+#include <atomic>
+#include <optional>
+
+struct AdsDatatypeEntry;
+
+// Finds the symbols, members and array elements that match a SymbolQuery. It
+// walks the rows of an AdsPathSpace instead of the tree model, so nothing is
+// expanded and no name is decoded for rows that do not match. Only the rows
+// that SymbolQuery::candidates() leaves are walked.
+//
+// The rows to walk are split into tasks of similar size, which a thread pool
+// works through. The hits of the tasks are reported in tree order through
+// hitsFound(), in batches, as soon as all tasks before have reported theirs.
+// The search is cancelled with requestInterruption().
+class SymbolSearch : public QThread
+{
+  Q_OBJECT
+
+public: // types
+  struct Hit
+  {
+    QList<int> rows;     // rows in AdsSymbolModel, from the top level down
+    QByteArray fullName; // raw
+    const AdsDatatypeEntry * adsType = nullptr;
+    quint64 ordinal = 0; // in the path space
+  };
+
+public: // methods
+  // The path space and index must outlive the search.
+  SymbolSearch(const AdsPathSpace & pathSpace, const AdsPathIndex & pathIndex,
+               const SymbolQuery & query, QObject * parent = nullptr);
+  ~SymbolSearch() override;
+
+  // Searches only the rows at ordinals, in ascending order, instead of all
+  // candidates of the query: the hits of a complete search for a query that
+  // this one narrows (see SymbolQuery::narrows()). Call before start().
+  void refine(const QList<quint64> & ordinals);
+
+  // Available after finished().
+  qsizetype hitCount() const { return mHitCount; }
+  bool isTruncated() const { return mTruncated; }
+
+signals:
+  void hitsFound(const QList<SymbolSearch::Hit> & hits);
+
+protected: // methods
+  void run() override;
+
+private: // types
+  // The ranges [first, last) of mRanges, searched by one worker.
+  struct Task
+  {
+    qsizetype first;
+    qsizetype last;
+  };
+
+private: // methods
+  void plan();
+  QList<Hit> search(const Task & task) const;
+
+private: // attributes
+  const AdsPathSpace & mPathSpace;
+  const AdsPathIndex & mPathIndex;
+  SymbolQuery mQuery;
+  std::optional<QList<AdsPathIndex::Range>> mRefined;
+
+  QList<AdsPathIndex::Range> mRanges;
+  QList<Task> mTasks;
+  std::atomic<bool> mCancelled{false};
+  qsizetype mHitCount = 0;
+  bool mTruncated = false;
+};
+
+Q_DECLARE_METATYPE(SymbolSearch::Hit)
@@ -7,29 +7,39 @@
 #include <QAction>
 #include <QApplication>
 #include <QClipboard>
-#include <QDir>
 #include <QFile>
 #include <QFileDialog>
-#include <QFileInfo>
-#include <QJsonArray>
-#include <QJsonDocument>
-#include <QJsonObject>
 #include <QKeyEvent>
 #include <QMessageBox>
 #include <QPushButton>
 #include <QSettings>
 #include <QSortFilterProxyModel>
-#include <QStandardPaths>
+#include <QTimer>
 #include <QVariant>
 
+#include <algorithm>
+#include <utility>
+
 #include "AdsCodec.h"
 #include "AdsDatatypeEntry.h"
 #include "AdsDatatypeIndex.h"
 #include "AdsDevice.h"
+#include "AdsReadPlan.h"
 #include "AdsSymbolIndex.h"
 #include "AdsSymbolModel.h"
 #include "AdsSymbolUploadInfo2.h"
 #include "RemoteRouteCreation.h"
+#include "SearchResultModel.h"
+#include "SymbolExport.h"
+#include "SymbolSearch.h"
+#include "TargetLoader.h"
+#include "WatchModel.h"
+
+// Typing pauses shorter than this, in ms, do not start a search.
+static constexpr int SearchDelay = 150;
+// Default for the "ReadMaxGap" setting: variables at most this many bytes
+// apart are read as one block.
+static constexpr uint32_t DefaultReadMaxGap = 64;
 
 struct RecentConnection
 {
@@ -50,11 +60,28 @@ TargetBrowser::TargetBrowser(QWidget * parent)
 {
   mUi->setupUi(this);
 
-  auto proxyModel = new QSortFilterProxyModel(this);
-  proxyModel->setAutoAcceptChildRows(true);
-  proxyModel->setRecursiveFilteringEnabled(true);
-  proxyModel->setFilterCaseSensitivity(Qt::CaseInsensitive);
-  mUi->targetView->setModel(proxyModel);
+  mProxyModel = new QSortFilterProxyModel(this);
+  mUi->targetView->setModel(mProxyModel);
+  mUi->targetView->setSelectionMode(QAbstractItemView::ExtendedSelection);
+  mUi->targetView->setDragDropMode(QAbstractItemView::DragOnly);
+
+  mWatchModel = new WatchModel(this);
+  mUi->watchView->setModel(mWatchModel);
+  mWatchModel->setView(mUi->watchView);
+  auto removeWatch = new QAction("Remove from watch list", mUi->watchView);
+  removeWatch->setShortcut(QKeySequence::Delete);
+  removeWatch->setShortcutContext(Qt::WidgetShortcut);
+  mUi->watchView->addAction(removeWatch);
+  connect(removeWatch, &QAction::triggered, this, &TargetBrowser::removeSelectedWatches);
+
+  mCancelButton = new QPushButton("Cancel", this);
+  mCancelButton->hide();
+  mUi->statusbar->addPermanentWidget(mCancelButton);
+  connect(mCancelButton, &QPushButton::clicked, this, &TargetBrowser::cancelLoading);
+  mCancelExportButton = new QPushButton("Cancel export", this);
+  mCancelExportButton->hide();
+  mUi->statusbar->addPermanentWidget(mCancelExportButton);
+  connect(mCancelExportButton, &QPushButton::clicked, this, &TargetBrowser::stopExport);
 
   mUi->action_Connect_to_recent->setMenu(new QMenu(this));
   connect(mUi->action_Connect, &QAction::triggered, this,
@@ -68,22 +95,39 @@ TargetBrowser::TargetBrowser(QWidget * parent)
           &TargetBrowser::copyFullNameToClipboard);
   connect(mUi->action_Read_value, &QAction::triggered, this,
           &TargetBrowser::readSelectedVariableValue);
-  connect(mUi->searchInput, &QLineEdit::textChanged, this,
-          [this](const QString & text)
+  connect(mUi->action_Watch, &QAction::triggered, this,
+          &TargetBrowser::watchSelectedVariables);
+  mSearchTimer = new QTimer(this);
+  mSearchTimer->setSingleShot(true);
+  mSearchTimer->setInterval(SearchDelay);
+  connect(mSearchTimer, &QTimer::timeout, this, [this]() { search(mUi->searchInput->text()); });
+  connect(mUi->searchInput, &QLineEdit::textChanged, mSearchTimer, qOverload<>(&QTimer::start));
+  connect(mUi->searchInput, &QLineEdit::returnPressed, this, [this]() { search(mUi->searchInput->text()); });
+  connect(mUi->targetView, &QAbstractItemView::activated, this,
+          [this](const QModelIndex & index)
           {
-            auto proxyModel = qobject_cast<QSortFilterProxyModel *>(mUi->targetView->model());
-            Q_ASSERT(proxyModel);
-            proxyModel->setFilterFixedString(text);
+            if (mUi->targetView->model() == mSearchModel)
+              revealSearchResult(index.row());
           });
   connect(mUi->actionCreate_remote_rou_te, &QAction::triggered, this,
           &TargetBrowser::onCreateRemoteRoute);
   connect(mUi->actionExport_Symbols, &QAction::triggered, this, &TargetBrowser::exportSymbols);
   connect(mUi->actionExport_Data_Types, &QAction::triggered, this, &TargetBrowser::exportDataTypes);
+  connect(mUi->actionExport_Variables, &QAction::triggered, this, &TargetBrowser::exportVariables);
+  connect(mUi->actionExport_Columns, &QAction::triggered, this, &TargetBrowser::exportColumns);
 
   loadRecentConnections();
 }
 
-TargetBrowser::~TargetBrowser() { delete mUi; }
+TargetBrowser::~TargetBrowser()
+{
+  // The notifications need the device.
+  mWatchModel->setTarget(nullptr, nullptr);
+  stopSearch();
+  stopExport();
+  delete mLoader;
+  delete mUi;
+}
 
 void TargetBrowser::onConnect()
 {
@@ -100,46 +144,75 @@ void TargetBrowser::onConnect()
 
 void TargetBrowser::connectToTarget()
 {
-  qDebug("Connecting to NetId: %s, IP: %s, Port: %d", qPrintable(mNetId),
-         qPrintable(mIp), mPort);
+  cancelLoading();
+
+  auto loader = new TargetLoader(mNetId, mIp, mPort, this);
+  mLoader = loader;
+  connect(loader, &TargetLoader::progress, this,
+          [this](const QString & message)
+          { mUi->statusbar->showMessage(message); });
+  connect(loader, &TargetLoader::connected, this,
+          [this, netId = mNetId, ip = mIp, port = mPort]()
+          {
+            addRecentConnection(netId, ip, port);
+            saveRecentConnections();
+          });
+  connect(loader, &TargetLoader::failed, this,
+          [this](const QString & title, const QString & message)
+          { QMessageBox::critical(this, title, message); });
+  connect(loader, &QThread::finished, this,
+          [this, loader]()
+          { onLoaderFinished(loader); });
+
+  mCancelButton->show();
+  loader->start();
+}
 
-  try
-  {
-    mAdsDevice.reset(
-        new AdsDevice(qPrintable(mIp), mNetId.toStdString(), mPort));
-  }
-  catch (const std::exception & e)
-  {
-    QMessageBox::critical(this, "Connection Error",
-                          strlen(e.what()) > 0 ? e.what() : "Unknown error");
-    qCritical("Failed to connect to target: %s", e.what());
+void TargetBrowser::cancelLoading()
+{
+  if (!mLoader)
     return;
-  }
 
-  if (mAdsDevice->GetLocalPort() == 0)
+  // The loader may be blocked in a request, so let it finish in the background.
+  auto loader = std::exchange(mLoader, nullptr);
+  disconnect(loader, nullptr, this, nullptr);
+  connect(loader, &QThread::finished, loader, &QObject::deleteLater);
+  loader->requestInterruption();
+  if (loader->isFinished())
+    loader->deleteLater();
+  mCancelButton->hide();
+  mUi->statusbar->showMessage("Connection cancelled.");
+}
+
+void TargetBrowser::onLoaderFinished(TargetLoader * loader)
+{
+  if (loader != mLoader)
+    return;
+  mLoader = nullptr;
+  mCancelButton->hide();
+  loader->deleteLater();
+
+  auto model = loader->takeModel();
+  if (!model)
   {
-    QMessageBox::critical(this, "Error", "Unable to open ads port");
+    // The last progress message would suggest it is still loading.
+    mUi->statusbar->showMessage("Connection failed.");
     return;
   }
 
-  mUi->statusbar->showMessage(
-      QString("Connected to NetId: %1, IP: %2, Port: %3")
-          .arg(mNetId, mIp)
-          .arg(mPort));
-
-  addRecentConnection(mNetId, mIp, mPort);
-  saveRecentConnections();
-
-  retrieveSymbolsAndTypes();
+  // The watch list refers to the old device and model.
+  mWatchModel->setTarget(nullptr, nullptr);
+  mAdsDevice = loader->takeDevice();
+  model->setParent(this);
 
-  auto typeIndex = AdsDatatypeIndex(mDatatypes);
-  auto symbolIndex = AdsSymbolIndex(mSymbols);
-
-  auto proxyModel = qobject_cast<QSortFilterProxyModel *>(mUi->targetView->model());
-  Q_ASSERT(proxyModel);
-  auto oldModel = proxyModel->sourceModel();
-  proxyModel->setSourceModel(new AdsSymbolModel(std::move(typeIndex), std::move(symbolIndex), this));
-  proxyModel->setFilterKeyColumn(AdsSymbolModel::FullNameColumn);
+  // The search, its results and an export refer to the old model.
+  stopSearch();
+  stopExport();
+  showModel(mProxyModel);
+  delete std::exchange(mSearchModel, nullptr);
+  mSearchComplete = false;
+  auto oldModel = mProxyModel->sourceModel();
+  mProxyModel->setSourceModel(model);
   delete oldModel;
   mUi->targetView->hideColumn(AdsSymbolModel::FullNameColumn);
   for (int c = 0; c < mUi->targetView->model()->columnCount(); ++c)
@@ -147,7 +220,15 @@ void TargetBrowser::connectToTarget()
 
   connect(mUi->targetView->selectionModel(),
           &QItemSelectionModel::currentChanged, this,
-          &TargetBrowser::onCurrentIndexChanged);
+          &TargetBrowser::onCurrentIndexChanged, Qt::UniqueConnection);
+
+  mWatchModel->setTarget(mAdsDevice.get(), model);
+  search(mUi->searchInput->text());
+
+  mUi->statusbar->showMessage(
+      QString("Connected to NetId: %1, IP: %2, Port: %3")
+          .arg(mNetId, mIp)
+          .arg(mPort));
 }
 
 void TargetBrowser::connectToRecentTarget(QAction * action)
@@ -228,94 +309,6 @@ void TargetBrowser::openRecentMenuAndFocusFirstItem()
   mUi->action_Connect_to_recent->menu()->activateWindow();
 }
 
-void TargetBrowser::retrieveSymbolsAndTypes()
-{
-  if (!mAdsDevice)
-  {
-    return;
-  }
-
-  mSymbols.clear();
-  mDatatypes.clear();
-
-  QString cacheFilename =
-      QStandardPaths::writableLocation(QStandardPaths::CacheLocation) +
-      "/symbols/" + mNetId;
-
-  if (loadFromCache())
-  {
-    return;
-  }
-
-  try
-  {
-    auto symbolUploadInfo = AdsSymbolUploadInfo2::fromDevice(*mAdsDevice);
-    mSymbols = symbolUploadInfo.uploadSymbols(*mAdsDevice);
-    mDatatypes = symbolUploadInfo.uploadDatatypes(*mAdsDevice);
-  }
-  catch (const std::exception & e)
-  {
-    QMessageBox::critical(this, "Error", e.what());
-    return;
-  }
-
-  saveToCache();
-}
-
-void TargetBrowser::saveToCache()
-{
-  QString cacheFilename =
-      QStandardPaths::writableLocation(QStandardPaths::CacheLocation) +
-      "/symbols/" + mNetId;
-
-  QDir::root().mkpath(QFileInfo(cacheFilename).absolutePath());
-  QFile cacheFile(cacheFilename);
-  if (!cacheFile.open(QIODevice::WriteOnly))
-  {
-    qWarning() << "Failed to open cache file for writing:" << cacheFilename;
-    return;
-  }
-
-  QDataStream out(&cacheFile);
-  out << mSymbols << mDatatypes;
-  if (out.status() != QDataStream::Ok)
-  {
-    qWarning() << "Failed to write symbols and datatypes to cache:"
-               << out.status();
-  }
-  else
-  {
-    qDebug() << "Symbols and datatypes saved to cache:" << cacheFilename;
-  }
-}
-
-bool TargetBrowser::loadFromCache()
-{
-  QString cacheFilename =
-      QStandardPaths::writableLocation(QStandardPaths::CacheLocation) +
-      "/symbols/" + mNetId;
-
-  if (!QFile::exists(cacheFilename))
-    return false;
-
-  QFile cacheFile(cacheFilename);
-  if (!cacheFile.open(QIODevice::ReadOnly))
-  {
-    qWarning() << "Failed to open cache file for reading:" << cacheFilename;
-    return false;
-  }
-  QDataStream in(&cacheFile);
-  in >> mSymbols >> mDatatypes;
-  if (in.status() != QDataStream::Ok)
-  {
-    qWarning() << "Failed to read symbols and datatypes from cache:"
-               << in.status();
-    return false;
-  }
-  qDebug() << "Loaded symbols and datatypes from cache:" << cacheFilename;
-  return true;
-}
-
 void TargetBrowser::copyFullNameToClipboard()
 {
   auto model = mUi->targetView->model();
@@ -343,52 +336,6 @@ void TargetBrowser::copyFullNameToClipboard()
   mUi->statusbar->showMessage(QString("Full name copied to clipboard: %1").arg(fullName));
 }
 
-static QVariant valueToVariant(const QByteArray & value, AdsDatatypeId type)
-{
-  switch (type)
-  {
-    case AdsDatatypeId::Void:
-      return QVariant();
-    case AdsDatatypeId::Bit:
-      return value.at(0) != 0;
-    case AdsDatatypeId::Int8:
-      return static_cast<int8_t>(value.at(0));
-    case AdsDatatypeId::UInt8:
-      return static_cast<uint8_t>(value.at(0));
-    case AdsDatatypeId::Int16:
-      return qFromLittleEndian<int16_t>(value.data());
-    case AdsDatatypeId::UInt16:
-      return qFromLittleEndian<uint16_t>(value.data());
-    case AdsDatatypeId::Int32:
-      return qFromLittleEndian<int32_t>(value.data());
-    case AdsDatatypeId::UInt32:
-      return qFromLittleEndian<uint32_t>(value.data());
-    case AdsDatatypeId::Int64:
-      return qFromLittleEndian<qint64>(value.data());
-    case AdsDatatypeId::UInt64:
-      return qFromLittleEndian<quint64>(value.data());
-    case AdsDatatypeId::Real32:
-      return qFromLittleEndian<float>(value.data());
-    case AdsDatatypeId::Real64:
-      return qFromLittleEndian<double>(value.data());
-    case AdsDatatypeId::Real80:
-      return QVariant::fromValue(qFromLittleEndian<long double>(value.data()));
-    case AdsDatatypeId::String:
-      return QString::fromUtf8(value); // or, use Ads::codec()?
-    case AdsDatatypeId::WString:
-      return QString::fromUtf16(
-          reinterpret_cast<const char16_t *>(value.data()),
-          value.size() / sizeof(char16_t));
-    case AdsDatatypeId::BigType:
-      // Handle BigType as a custom type, or return as QByteArray
-      return QString("Unresolved struct, hex dump: %1")
-          .arg(value.toHex());
-    default:
-      break;
-  }
-  return QString("Unknown type %1").arg(int(type)); // Default case
-}
-
 void TargetBrowser::onCurrentIndexChanged()
 {
   auto model = mUi->targetView->model();
@@ -415,13 +362,13 @@ void TargetBrowser::onCurrentIndexChanged()
                                           AdsSymbolModel::FullNameColumn,
                                           selectedIndex.parent()),
                              Qt::UserRole)
-                        .value<const AdsSymbolModel::SymbolNode *>();
-  if (!symbolNode)
+                        .value<AdsSymbolModel::SymbolNode>();
+  if (!symbolNode.symbol)
     return;
 
-  auto pathParts = QList{Ads::codec()->toUnicode(symbolNode->symbol->name())};
-  if (selectedIndex.parent().isValid())
-    pathParts << symbolNode->type->fullName().split('.');
+  auto pathParts = QList{Ads::toUnicode(symbolNode.symbol->rawName())};
+  if (symbolNode.type->parent())
+    pathParts << symbolNode.type->fullName().split('.');
 
   for (int iPathPart = 0; iPathPart < pathParts.size(); ++iPathPart)
   {
@@ -455,6 +402,10 @@ void TargetBrowser::goToLevel(int level)
     return;
   }
 
+  // The levels are only there in the tree.
+  if (model == mSearchModel)
+    revealSearchResult(mUi->targetView->selectionModel()->currentIndex().row());
+
   auto selectedIndex =
       mUi->targetView->selectionModel()->currentIndex();
   auto parents = QList{selectedIndex};
@@ -465,6 +416,25 @@ void TargetBrowser::goToLevel(int level)
   mUi->targetView->setCurrentIndex(parents.value(level));
 }
 
+QList<AdsSymbolModel::SymbolNode> TargetBrowser::selectedSymbolNodes() const
+{
+  auto model = mUi->targetView->model();
+  QList<AdsSymbolModel::SymbolNode> symbolNodes;
+  for (const auto & selectedIndex : mUi->targetView->selectionModel()->selectedIndexes())
+  {
+    if (selectedIndex.column() != 0)
+      continue;
+    auto fullNameIndex =
+        model->index(selectedIndex.row(), AdsSymbolModel::FullNameColumn,
+                     selectedIndex.parent());
+    auto symbolNode = model->data(fullNameIndex, Qt::UserRole)
+                          .value<AdsSymbolModel::SymbolNode>();
+    if (symbolNode.symbol)
+      symbolNodes << symbolNode;
+  }
+  return symbolNodes;
+}
+
 void TargetBrowser::readSelectedVariableValue()
 {
   if (!mAdsDevice)
@@ -473,43 +443,52 @@ void TargetBrowser::readSelectedVariableValue()
     return;
   }
 
-  auto model = mUi->targetView->model();
+  auto model = symbolModel();
   if (!model)
   {
     mUi->statusbar->showMessage("No data loaded.");
     return;
   }
 
-  auto selectedIndex =
-      mUi->targetView->selectionModel()->selectedIndexes().value(0);
-  auto fullNameIndex =
-      model->index(selectedIndex.row(), AdsSymbolModel::FullNameColumn,
-                   selectedIndex.parent());
-  auto symbolNode = model->data(fullNameIndex, Qt::UserRole)
-                        .value<const AdsSymbolModel::SymbolNode *>();
-  if (!(symbolNode))
+  auto symbolNodes = selectedSymbolNodes();
+  if (symbolNodes.isEmpty())
   {
     mUi->statusbar->showMessage("Invalid variable.");
     return;
   }
 
+  QList<Ads::ReadRequest> requests;
+  requests.reserve(symbolNodes.size());
+  for (const auto & symbolNode : symbolNodes)
+    requests << Ads::ReadRequest{symbolNode.group(), symbolNode.offset(), symbolNode.type->adsType()->size};
+
   try
   {
-    QByteArray value(symbolNode->type->adsType()->size, Qt::Uninitialized);
-    auto result =
-        mAdsDevice->ReadReqEx2(
-            symbolNode->group(),
-            symbolNode->offset(),
-            value.size(),
-            value.data(), nullptr);
-    if (result != ADSERR_NOERR)
-      throw AdsException(result);
-
-    auto interpretedValue = valueToVariant(
-        value,
-        AdsDatatypeId(symbolNode->type->adsType()->dataType));
-
-    mUi->statusbar->showMessage(QString("Value read: %1").arg(interpretedValue.toString()));
+    auto maxGap = QSettings().value("ReadMaxGap", DefaultReadMaxGap).toUInt();
+    auto results = Ads::ReadPlan(requests, maxGap).read(*mAdsDevice);
+
+    QStringList values;
+    for (qsizetype i = 0; i < symbolNodes.size(); ++i)
+    {
+      const auto & symbolNode = symbolNodes[i];
+      QString value;
+      if (results[i].error != ADSERR_NOERR)
+        value = QString("error %1").arg(results[i].error);
+      else
+        value = model->valueDecoder().toVariant(results[i].data, symbolNode.type->adsType()).toString();
+      if (symbolNodes.size() == 1)
+      {
+        values << value;
+        break;
+      }
+      values << QString("%1 = %2").arg(symbolNode.fullName(), value);
+    }
+
+    if (symbolNodes.size() == 1 && results.first().error != ADSERR_NOERR)
+      throw AdsException(results.first().error);
+    mUi->statusbar->showMessage(
+        QString(symbolNodes.size() == 1 ? "Value read: %1" : "Values read: %1")
+            .arg(values.join(", ")));
   }
   catch (const std::exception & e)
   {
@@ -518,6 +497,35 @@ void TargetBrowser::readSelectedVariableValue()
   }
 }
 
+void TargetBrowser::watchSelectedVariables()
+{
+  auto model = symbolModel();
+  if (!model)
+  {
+    mUi->statusbar->showMessage("No data loaded.");
+    return;
+  }
+
+  for (const auto & index : mUi->targetView->selectionModel()->selectedIndexes())
+  {
+    if (index.column() != 0)
+      continue;
+    auto sourceIndex = mUi->targetView->model() == mSearchModel
+                           ? mSearchModel->symbolModelIndex(index.row())
+                           : mProxyModel->mapToSource(index);
+    mWatchModel->addVariable(model->rowsForIndex(sourceIndex));
+  }
+  mUi->watchDock->show();
+}
+
+void TargetBrowser::removeSelectedWatches()
+{
+  auto rows = mUi->watchView->selectionModel()->selectedRows();
+  std::sort(rows.begin(), rows.end(), [](const QModelIndex & a, const QModelIndex & b) { return a.row() > b.row(); });
+  for (const auto & index : rows)
+    mWatchModel->removeRow(index.row());
+}
+
 void TargetBrowser::onCreateRemoteRoute()
 {
   RouteCreationDialog dialog(this);
@@ -547,54 +555,189 @@ void TargetBrowser::onCreateRemoteRoute()
 
 AdsSymbolModel * TargetBrowser::symbolModel() const
 {
-  return static_cast<AdsSymbolModel *>(
-      static_cast<QSortFilterProxyModel *>(
-          mUi->targetView->model())
-          ->sourceModel());
+  return static_cast<AdsSymbolModel *>(mProxyModel->sourceModel());
 }
 
-void TargetBrowser::exportSymbols()
+void TargetBrowser::showModel(QAbstractItemModel * model)
 {
-  auto model = symbolModel();
-  if (!model)
+  if (mUi->targetView->model() == model)
     return;
 
-  QString fileName = QFileDialog::getSaveFileName(this, tr("Export Symbols"), QString(), tr("JSON Files (*.json)"));
-  if (fileName.isEmpty())
-    return;
+  // The view creates a new selection model, but leaves the old one to us.
+  auto oldSelectionModel = mUi->targetView->selectionModel();
+  mUi->targetView->setModel(model);
+  delete oldSelectionModel;
+  mUi->targetView->hideColumn(AdsSymbolModel::FullNameColumn);
+  connect(mUi->targetView->selectionModel(),
+          &QItemSelectionModel::currentChanged, this,
+          &TargetBrowser::onCurrentIndexChanged);
+}
+
+void TargetBrowser::search(const QString & text)
+{
+  mSearchTimer->stop();
+  stopSearch();
 
-  QJsonArray arr;
-  const auto & symbols = model->symbolIndex().entries();
-  for (const auto & entry : symbols)
+  auto model = symbolModel();
+  auto query = SymbolQuery::parse(text);
+  if (!model || (query.isValid() && query.isEmpty()))
   {
-    arr.append(entry->toJson());
+    showModel(mProxyModel);
+    if (mSearchModel)
+      mSearchModel->clear();
+    mSearchComplete = false;
+    return;
+  }
+  if (!query.isValid())
+  {
+    // Likely still being typed; the last results stay.
+    mUi->statusbar->showMessage(query.errorString());
+    return;
   }
-  QJsonDocument doc(arr);
-  QFile file(fileName);
-  if (file.open(QIODevice::WriteOnly))
-    file.write(doc.toJson());
+
+  if (!mSearchModel)
+    mSearchModel = new SearchResultModel(model, this);
+  auto search = new SymbolSearch(model->pathSpace(), model->pathIndex(), query, this);
+  // A query typed further only needs to look at the hits it already has.
+  if (mSearchComplete && query.narrows(mSearchedQuery))
+    search->refine(mSearchModel->ordinals());
+  mSearchedQuery = query;
+  mSearchComplete = false;
+  mSearchModel->clear();
+  showModel(mSearchModel);
+
+  mSearch = search;
+  // Batches of a search that was stopped may still be queued; they are
+  // recognized by the generation.
+  auto generation = ++mSearchGeneration;
+  connect(search, &SymbolSearch::hitsFound, this,
+          [this, generation](const QList<SymbolSearch::Hit> & hits)
+          {
+            if (generation == mSearchGeneration)
+              mSearchModel->appendHits(hits);
+          });
+  connect(search, &QThread::finished, this,
+          [this, search, generation]()
+          {
+            if (generation != mSearchGeneration)
+              return;
+            mSearchComplete = !search->isTruncated();
+            mUi->statusbar->showMessage(
+                QString(search->isTruncated() ? "Showing the first %1 matches." : "%1 matches.")
+                    .arg(search->hitCount()));
+          });
+  mUi->statusbar->showMessage("Searching...");
+  search->start();
 }
 
-void TargetBrowser::exportDataTypes()
+void TargetBrowser::stopSearch()
 {
-  auto model = symbolModel();
-  if (!model)
+  if (!mSearch)
+    return;
+  ++mSearchGeneration;
+  // The search checks for interruption every few hundred rows, so this does
+  // not block noticeably.
+  delete std::exchange(mSearch, nullptr);
+}
+
+void TargetBrowser::revealSearchResult(int row)
+{
+  if (!mSearchModel)
+    return;
+  auto index = mProxyModel->mapFromSource(mSearchModel->symbolModelIndex(row));
+  if (!index.isValid())
     return;
 
-  QString fileName = QFileDialog::getSaveFileName(this, tr("Export Data Types"), QString(), tr("JSON Files (*.json)"));
+  mUi->searchInput->clear();
+  search(QString()); // switches back to the tree without waiting for the timer
+  mUi->targetView->scrollTo(index);
+  mUi->targetView->setCurrentIndex(index);
+}
+
+void TargetBrowser::exportSymbols()
+{
+  auto fileName = QFileDialog::getSaveFileName(this, tr("Export Symbols"), QString(), tr("JSON Files (*.json)"));
+  if (!fileName.isEmpty())
+    startExport(SymbolExport::Format::SymbolsJson, fileName);
+}
+
+void TargetBrowser::exportDataTypes()
+{
+  auto fileName = QFileDialog::getSaveFileName(this, tr("Export Data Types"), QString(), tr("JSON Files (*.json)"));
+  if (!fileName.isEmpty())
+    startExport(SymbolExport::Format::DataTypesJson, fileName);
+}
+
+void TargetBrowser::exportVariables()
+{
+  auto csvFilter = tr("CSV Files (*.csv)");
+  auto jsonLinesFilter = tr("JSON Lines Files (*.jsonl)");
+  QString selectedFilter;
+  auto fileName = QFileDialog::getSaveFileName(this, tr("Export Variables"), QString(),
+                                               csvFilter + ";;" + jsonLinesFilter, &selectedFilter);
   if (fileName.isEmpty())
     return;
+  startExport(selectedFilter == jsonLinesFilter ? SymbolExport::Format::LeavesJsonLines
+                                                : SymbolExport::Format::LeavesCsv,
+              fileName);
+}
+
+void TargetBrowser::exportColumns()
+{
+  auto fileName = QFileDialog::getSaveFileName(this, tr("Export Variables as Columns"), QString(),
+                                               tr("Symbol Columns (*.adscol)"));
+  if (!fileName.isEmpty())
+    startExport(SymbolExport::Format::Columns, fileName);
+}
 
-  QJsonArray arr;
-  const auto & types = model->typeIndex().entries();
-  for (const auto & entry : types)
+void TargetBrowser::startExport(SymbolExport::Format format, const QString & fileName)
+{
+  auto model = symbolModel();
+  if (!model)
   {
-    arr.append(entry->adsType()->toJson());
+    mUi->statusbar->showMessage("No data loaded.");
+    return;
   }
-  QJsonDocument doc(arr);
-  QFile file(fileName);
-  if (file.open(QIODevice::WriteOnly))
-    file.write(doc.toJson());
+
+  stopExport();
+  auto symbolExport = new SymbolExport(*model, format, fileName, this);
+  mExport = symbolExport;
+  connect(symbolExport, &SymbolExport::progress, this,
+          [this, symbolExport](qint64 done, qint64 total)
+          {
+            if (symbolExport == mExport)
+              mUi->statusbar->showMessage(QString("Exporting... %1%").arg(total > 0 ? done * 100 / total : 100));
+          });
+  connect(symbolExport, &QThread::finished, this,
+          [this, symbolExport, fileName]()
+          {
+            if (symbolExport != mExport)
+              return;
+            mExport = nullptr;
+            symbolExport->deleteLater();
+            mCancelExportButton->hide();
+            if (symbolExport->errorString().isEmpty())
+              mUi->statusbar->showMessage(
+                  QString("Exported %1 entries to %2.").arg(symbolExport->entryCount()).arg(fileName));
+            else
+              QMessageBox::warning(this, tr("Export failed"),
+                                   QString("Could not export to %1: %2").arg(fileName, symbolExport->errorString()));
+          });
+
+  mCancelExportButton->show();
+  mUi->statusbar->showMessage("Exporting...");
+  symbolExport->start();
+}
+
+void TargetBrowser::stopExport()
+{
+  if (!mExport)
+    return;
+  // The export checks for interruption after each entry, so this does not
+  // block noticeably. The partial file is discarded.
+  delete std::exchange(mExport, nullptr);
+  mCancelExportButton->hide();
+  mUi->statusbar->showMessage("Export cancelled.");
 }
 
 int main(int argc, char * argv[])
@@ -2,9 +2,20 @@
 
 #include <QMainWindow>
 
+#include "AdsSymbolModel.h"
 #include "AdsSymbolUploadInfo2.h"
-
-class AdsSymbolModel;
+#include "SymbolExport.h"
+#include "SymbolQuery.h"
+
+class AdsDevice;
+class QAbstractItemModel;
+class QPushButton;
+class QSortFilterProxyModel;
+class QTimer;
+class SearchResultModel;
+class SymbolSearch;
+class TargetLoader;
+class WatchModel;
 
 namespace Ui
 {
@@ -23,6 +34,8 @@ public:
 private slots:
   void exportSymbols();
   void exportDataTypes();
+  void exportVariables();
+  void exportColumns();
 
 private: // methods
   void connectToTarget();
@@ -33,19 +46,29 @@ private: // methods
   void loadRecentConnections();
   void openRecentMenuAndFocusFirstItem();
 
-  void retrieveSymbolsAndTypes();
-  void saveToCache();
-  bool loadFromCache();
+  void cancelLoading();
+  void onLoaderFinished(TargetLoader * loader);
 
   void onCurrentIndexChanged();
   void goToLevel(int level);
 
+  QList<AdsSymbolModel::SymbolNode> selectedSymbolNodes() const;
   void readSelectedVariableValue();
+  void watchSelectedVariables();
+  void removeSelectedWatches();
   void copyFullNameToClipboard();
 
   void onCreateRemoteRoute();
 
   AdsSymbolModel * symbolModel() const;
+  void showModel(QAbstractItemModel * model);
+
+  void search(const QString & text);
+  void stopSearch();
+  void revealSearchResult(int row);
+
+  void startExport(SymbolExport::Format format, const QString & fileName);
+  void stopExport();
 
 private: // attributes
   Ui::TargetBrowser * mUi = nullptr;
@@ -53,7 +76,19 @@ private: // attributes
   QString mIp;
   int mPort = 581;
 
-  std::unique_ptr<class AdsDevice> mAdsDevice;
-  QByteArray mSymbols;
-  QByteArray mDatatypes;
+  QPushButton * mCancelButton = nullptr; // cancels the loading
+  QPushButton * mCancelExportButton = nullptr;
+  TargetLoader * mLoader = nullptr;
+  QSortFilterProxyModel * mProxyModel = nullptr;
+  SearchResultModel * mSearchModel = nullptr;
+  WatchModel * mWatchModel = nullptr;
+  SymbolSearch * mSearch = nullptr;
+  SymbolExport * mExport = nullptr;
+  quint64 mSearchGeneration = 0;
+  QTimer * mSearchTimer = nullptr; // delays the search while typing
+  // The query whose hits mSearchModel holds; they are all of them, if
+  // mSearchComplete.
+  SymbolQuery mSearchedQuery;
+  bool mSearchComplete = false;
+  std::unique_ptr<AdsDevice> mAdsDevice;
 };
@@ -0,0 +1,215 @@
+#include "TargetLoader.h"
+
+#include <QCoreApplication>
+#include <QDebug>
+#include <QSettings>
+
+#include <cstring>
+#include <utility>
+
+#include "AdsDatatypeIndex.h"
+#include "AdsDevice.h"
+#include "AdsSymbolIndex.h"
+#include "AdsSymbolModel.h"
+#include "AdsSymbolUploadInfo2.h"
+#include "SymbolCache.h"
+
+// Default for the "UploadChunkSize" setting; 0 uploads each table in one request.
+static constexpr uint32_t DefaultUploadChunkSize = 64 * 1024;
+// Default for the "SearchIndexMaxRows" setting: targets with more rows are
+// searched without an index. 0 never builds one.
+static constexpr quint64 DefaultSearchIndexMaxRows = 5000000;
+
+TargetLoader::TargetLoader(const QString & netId, const QString & ip, int port, QObject * parent)
+    : QThread(parent), mNetId(netId), mIp(ip), mPort(port)
+{
+}
+
+TargetLoader::~TargetLoader()
+{
+  requestInterruption();
+  wait();
+  delete mModel;
+}
+
+std::unique_ptr<AdsDevice> TargetLoader::takeDevice()
+{
+  return std::move(mAdsDevice);
+}
+
+AdsSymbolModel * TargetLoader::takeModel()
+{
+  return std::exchange(mModel, nullptr);
+}
+
+void TargetLoader::run()
+{
+  qDebug("Connecting to NetId: %s, IP: %s, Port: %d", qPrintable(mNetId),
+         qPrintable(mIp), mPort);
+  emit progress(QString("Connecting to NetId: %1, IP: %2, Port: %3...")
+                    .arg(mNetId, mIp)
+                    .arg(mPort));
+
+  try
+  {
+    mAdsDevice.reset(
+        new AdsDevice(qPrintable(mIp), mNetId.toStdString(), mPort));
+  }
+  catch (const std::exception & e)
+  {
+    emit failed("Connection Error",
+                strlen(e.what()) > 0 ? e.what() : "Unknown error");
+    qCritical("Failed to connect to target: %s", e.what());
+    mAdsDevice.reset();
+    return;
+  }
+
+  if (mAdsDevice->GetLocalPort() == 0)
+  {
+    emit failed("Error", "Unable to open ads port");
+    mAdsDevice.reset();
+    return;
+  }
+
+  emit connected();
+
+  SymbolCache cache(mNetId);
+  SymbolCache::Stamp stamp;
+  try
+  {
+    emit progress("Reading symbol upload info...");
+    stamp = SymbolCache::Stamp::fromDevice(*mAdsDevice);
+  }
+  catch (const std::exception & e)
+  {
+    emit failed("Error", e.what());
+    mAdsDevice.reset();
+    return;
+  }
+
+  if (!loadFromCache(cache, stamp))
+  {
+    if (!upload(stamp))
+    {
+      mAdsDevice.reset();
+      return;
+    }
+    // Saved right away, so that cancelling a later stage keeps the upload.
+    // The search index is added once it is built.
+    cache.save(stamp, {mSymbolIndex->upload(), mTypeIndex->upload(), mSymbolIndex->nameTable().data(),
+                       mTypeIndex->nameTable().data(), QByteArray()});
+  }
+  if (isInterruptionRequested())
+  {
+    mAdsDevice.reset();
+    return;
+  }
+
+  emit progress("Building symbol model...");
+  auto model = new AdsSymbolModel(std::move(*mTypeIndex), std::move(*mSymbolIndex));
+  mTypeIndex.reset();
+  mSymbolIndex.reset();
+  if (isInterruptionRequested())
+  {
+    delete model;
+    mAdsDevice.reset();
+    return;
+  }
+
+  auto built = buildPathIndex(*model);
+  if (isInterruptionRequested())
+  {
+    delete model;
+    mAdsDevice.reset();
+    return;
+  }
+  if (built)
+    cache.savePathIndex(stamp, model->pathIndex().data());
+  model->moveToThread(QCoreApplication::instance()->thread());
+  mModel = model;
+}
+
+bool TargetLoader::upload(const SymbolCache::Stamp & stamp)
+{
+  const auto & symbolUploadInfo = stamp.uploadInfo;
+  try
+  {
+    auto chunkSize = QSettings().value("UploadChunkSize", DefaultUploadChunkSize).toUInt();
+
+    // The indexes take the records as soon as they are complete, so parsing
+    // overlaps with the transfer of the next chunk.
+    mTypeIndex = std::make_unique<AdsDatatypeIndex>(qsizetype(symbolUploadInfo.nDatatypeSize));
+    auto complete = symbolUploadInfo.uploadDatatypes(
+        *mAdsDevice, mTypeIndex->uploadBuffer(), chunkSize,
+        [&](uint32_t bytesAvailable)
+        {
+          mTypeIndex->build(bytesAvailable);
+          emit progress(QString("Uploading %1 data types (%2 of %3 bytes)...")
+                            .arg(symbolUploadInfo.nDatatypes)
+                            .arg(bytesAvailable)
+                            .arg(symbolUploadInfo.nDatatypeSize));
+          return !isInterruptionRequested();
+        });
+    if (!complete)
+      return false;
+
+    mSymbolIndex = std::make_unique<AdsSymbolIndex>(qsizetype(symbolUploadInfo.nSymSize));
+    complete = symbolUploadInfo.uploadSymbols(
+        *mAdsDevice, mSymbolIndex->uploadBuffer(), chunkSize,
+        [&](uint32_t bytesAvailable)
+        {
+          mSymbolIndex->build(bytesAvailable);
+          emit progress(QString("Uploading %1 symbols (%2 of %3 bytes)...")
+                            .arg(symbolUploadInfo.nSymbols)
+                            .arg(bytesAvailable)
+                            .arg(symbolUploadInfo.nSymSize));
+          return !isInterruptionRequested();
+        });
+    if (!complete)
+      return false;
+  }
+  catch (const std::exception & e)
+  {
+    emit failed("Error", e.what());
+    return false;
+  }
+  return true;
+}
+
+bool TargetLoader::buildPathIndex(AdsSymbolModel & model)
+{
+  const auto & pathSpace = model.pathSpace();
+  auto pathIndex = AdsPathIndex::fromData(std::exchange(mCachedPathIndex, QByteArray()), pathSpace.rowCount());
+  bool built = false;
+  if (pathIndex.isEmpty())
+  {
+    auto maxRows = QSettings().value("SearchIndexMaxRows", DefaultSearchIndexMaxRows).toULongLong();
+    if (pathSpace.rowCount() > maxRows)
+      return false;
+    emit progress(QString("Building search index of %1 rows...").arg(pathSpace.rowCount()));
+    pathIndex = AdsPathIndex::build(pathSpace, [this]() { return isInterruptionRequested(); });
+    built = !pathIndex.isEmpty();
+  }
+  model.setPathIndex(std::move(pathIndex));
+  return built;
+}
+
+bool TargetLoader::loadFromCache(const SymbolCache & cache, const SymbolCache::Stamp & stamp)
+{
+  emit progress("Loading symbols from cache...");
+  auto mapping = cache.load(stamp);
+  if (!mapping)
+    return false;
+
+  // The indexes point straight into the mapped file and keep it mapped. Their
+  // name tables were stored along with the uploads and need not be rebuilt.
+  mTypeIndex = std::make_unique<AdsDatatypeIndex>(mapping->section(SymbolCache::DatatypesSection),
+                                                  mapping->section(SymbolCache::DatatypeNamesSection),
+                                                  mapping);
+  mSymbolIndex = std::make_unique<AdsSymbolIndex>(mapping->section(SymbolCache::SymbolsSection),
+                                                  mapping->section(SymbolCache::SymbolNamesSection),
+                                                  mapping);
+  // Kept mapped by the indexes, too.
+  mCachedPathIndex = mapping->section(SymbolCache::PathIndexSection);
+  return true;
+}
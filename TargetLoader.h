@@ -0,0 +1,57 @@
+#pragma once
+
+#include <QString>
+#include <QThread>
+
+#include "SymbolCache.h"
+
+#include <memory>
+
+class AdsDatatypeIndex;
+class AdsDevice;
+class AdsSymbolIndex;
+class AdsSymbolModel;
+
+// Runs the connect pipeline off the GUI thread: open the ADS port, load the
+// symbols and datatypes from the cache if it is still up to date or upload
+// them, build the indexes, the model and the search index. Each stage is announced
+// through progress(); the loader can be cancelled with requestInterruption()
+// between stages.
+class TargetLoader : public QThread
+{
+  Q_OBJECT
+
+public: // methods
+  TargetLoader(const QString & netId, const QString & ip, int port, QObject * parent = nullptr);
+  ~TargetLoader() override;
+
+  // The results, available after finished() if the pipeline ran to the end.
+  // The model lives in the GUI thread and has no parent.
+  std::unique_ptr<AdsDevice> takeDevice();
+  AdsSymbolModel * takeModel();
+
+signals:
+  void progress(const QString & message);
+  void connected();
+  void failed(const QString & title, const QString & message);
+
+protected: // methods
+  void run() override;
+
+private: // methods
+  bool loadFromCache(const SymbolCache & cache, const SymbolCache::Stamp & stamp);
+  bool upload(const SymbolCache::Stamp & stamp);
+  // Returns whether a new index was built, i.e. it is not in the cache yet.
+  bool buildPathIndex(AdsSymbolModel & model);
+
+private: // attributes
+  QString mNetId;
+  QString mIp;
+  int mPort = 581;
+
+  std::unique_ptr<AdsDevice> mAdsDevice;
+  std::unique_ptr<AdsDatatypeIndex> mTypeIndex;
+  std::unique_ptr<AdsSymbolIndex> mSymbolIndex;
+  QByteArray mCachedPathIndex; // view into the cache mapping
+  AdsSymbolModel * mModel = nullptr;
+};
@@ -0,0 +1,97 @@
+#include "UpdateCoalescer.h"
+
+#include <QAbstractItemView>
+#include <QGuiApplication>
+#include <QScreen>
+#include <QTimer>
+
+#include <algorithm>
+#include <limits>
+
+// Clean rows between two dirty ones up to which both go into one range. An
+// extra signal costs more than repainting a few rows.
+static constexpr int MaxGap = 4;
+
+UpdateCoalescer::UpdateCoalescer(QObject * parent)
+    : QObject(parent)
+{
+  mFrameTimer = new QTimer(this);
+  mFrameTimer->setSingleShot(true);
+  mFrameTimer->setTimerType(Qt::PreciseTimer);
+  connect(mFrameTimer, &QTimer::timeout, this, &UpdateCoalescer::flush);
+}
+
+void UpdateCoalescer::setView(QAbstractItemView * view)
+{
+  mView = view;
+}
+
+void UpdateCoalescer::markDirty(int row)
+{
+  if (row >= mDirty.size())
+    mDirty.resize(std::max<qsizetype>(row + 1, 2 * mDirty.size()));
+  mDirty.setBit(row);
+  if (mFirstDirty > mLastDirty)
+  {
+    mFirstDirty = mLastDirty = row;
+  }
+  else
+  {
+    mFirstDirty = std::min(mFirstDirty, row);
+    mLastDirty = std::max(mLastDirty, row);
+  }
+
+  if (!mFrameTimer->isActive())
+  {
+    auto screen = QGuiApplication::primaryScreen();
+    auto refreshRate = screen ? screen->refreshRate() : 60.0;
+    mFrameTimer->start(std::max(1, int(1000 / std::max(refreshRate, 1.0))));
+  }
+}
+
+void UpdateCoalescer::clear()
+{
+  mFrameTimer->stop();
+  mDirty.fill(false);
+  mFirstDirty = 0;
+  mLastDirty = -1;
+}
+
+void UpdateCoalescer::flush()
+{
+  auto first = mFirstDirty;
+  auto last = mLastDirty;
+  if (mView)
+  {
+    if (!mView->isVisible())
+    {
+      clear();
+      return;
+    }
+    auto viewport = mView->viewport();
+    auto top = mView->indexAt(QPoint(0, 0));
+    auto bottom = mView->indexAt(QPoint(0, viewport->height() - 1));
+    first = std::max(first, top.isValid() ? top.row() : 0);
+    last = std::min(last, bottom.isValid() ? bottom.row() : std::numeric_limits<int>::max());
+  }
+
+  int rangeFirst = -1;
+  int rangeLast = -1;
+  for (int row = first; row <= last; ++row)
+  {
+    if (!mDirty.testBit(row))
+      continue;
+    if (rangeFirst >= 0 && row - rangeLast > MaxGap + 1)
+    {
+      emit rowsChanged(rangeFirst, rangeLast);
+      rangeFirst = -1;
+    }
+    if (rangeFirst < 0)
+      rangeFirst = row;
+    rangeLast = row;
+  }
+  if (rangeFirst >= 0)
+    emit rowsChanged(rangeFirst, rangeLast);
+
+  clear();
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <QBitArray>
+#include <QObject>
+#include <QPointer>
+
+class QAbstractItemView;
+class QTimer;
+
+// Collects the rows of a flat model whose data changed and reports them at
+// most once per display frame, through rowsChanged(), as few merged ranges.
+// Rows the view does not show are dropped; the view asks for their data
+// anyway when they scroll into sight. So however often the values change,
+// the view repaints at most the visible rows once per frame.
+class UpdateCoalescer : public QObject
+{
+  Q_OBJECT
+
+public: // methods
+  explicit UpdateCoalescer(QObject * parent = nullptr);
+
+  // Without a view, all rows count as visible.
+  void setView(QAbstractItemView * view);
+
+  void markDirty(int row);
+  // Forgets the dirty rows, e.g. when the model is reset.
+  void clear();
+
+signals:
+  void rowsChanged(int firstRow, int lastRow);
+
+private: // methods
+  void flush();
+
+private: // attributes
+  QPointer<QAbstractItemView> mView;
+  QTimer * mFrameTimer = nullptr;
+  QBitArray mDirty;
+  int mFirstDirty = 0;
+  int mLastDirty = -1;
+};
@@ -0,0 +1,340 @@
+#include "WatchModel.h"
+
+#include "AdsCodec.h"
+#include "AdsDevice.h"
+#include "AdsSymbolModel.h"
+#include "UpdateCoalescer.h"
+
+#include <QDateTime>
+#include <QDebug>
+#include <QMimeData>
+#include <QTimer>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <thread>
+
+// How often the samples are taken from the queue into the model, in ms.
+static constexpr int DrainInterval = 50;
+
+// The AdsLib callback gets nothing but a 32-bit user value. Its upper SlotBits
+// select the queue of the watch model in this table, the others the item.
+static constexpr int SlotBits = 8;
+static constexpr int KeyBits = 32 - SlotBits;
+static constexpr uint32_t KeyMask = (1u << KeyBits) - 1;
+static std::array<std::atomic<NotificationQueue *>, 1 << SlotBits> sQueues;
+// Callbacks running for each slot, so that a queue is only destroyed once no
+// callback can still be pushing to it.
+static std::array<std::atomic<int>, 1 << SlotBits> sCallbacksInSlot;
+
+// FILETIME epoch (1601-01-01) to Unix epoch, in 100 ns
+static constexpr uint64_t FileTimeToUnixEpoch = 116444736000000000ull;
+
+WatchModel::WatchModel(QObject * parent)
+    : QAbstractTableModel(parent)
+{
+  for (int slot = 0; slot < int(sQueues.size()) && mSlot < 0; ++slot)
+  {
+    NotificationQueue * free = nullptr;
+    if (sQueues[slot].compare_exchange_strong(free, &mQueue))
+      mSlot = slot;
+  }
+  if (mSlot < 0)
+    qCritical() << "Too many watch lists, notifications are disabled.";
+
+  mDrainTimer = new QTimer(this);
+  mDrainTimer->setInterval(DrainInterval);
+  connect(mDrainTimer, &QTimer::timeout, this, &WatchModel::drain);
+
+  mCoalescer = new UpdateCoalescer(this);
+  connect(mCoalescer, &UpdateCoalescer::rowsChanged, this,
+          [this](int firstRow, int lastRow)
+          {
+            lastRow = std::min(lastRow, int(mItems.size()) - 1);
+            if (firstRow <= lastRow)
+              emit dataChanged(index(firstRow, ValueColumn), index(lastRow, TimestampColumn), {Qt::DisplayRole});
+          });
+}
+
+WatchModel::~WatchModel()
+{
+  // Deleting a notification does not wait for a callback already running on
+  // the AdsLib thread, which may still have got mQueue from the slot.
+  if (mSlot >= 0)
+  {
+    sQueues[mSlot] = nullptr;
+    while (sCallbacksInSlot[mSlot].load() > 0)
+      std::this_thread::yield();
+  }
+  clear();
+}
+
+void WatchModel::setTarget(const AdsDevice * device, const AdsSymbolModel * symbolModel)
+{
+  beginResetModel();
+  clear();
+  mDevice = device;
+  mSymbolModel = symbolModel;
+  endResetModel();
+}
+
+void WatchModel::clear()
+{
+  // Deleting the notifications stops the callbacks for them.
+  mItems.clear();
+  mRows.clear();
+  mDrainTimer->stop();
+  mCoalescer->clear();
+  mQueue.drain([](const NotificationQueue::Sample &) {});
+}
+
+void WatchModel::setView(QAbstractItemView * view)
+{
+  mCoalescer->setView(view);
+}
+
+void WatchModel::addVariable(const QList<int> & rows)
+{
+  if (!mSymbolModel)
+    return;
+  auto index = mSymbolModel->indexForRows(rows, AdsSymbolModel::FullNameColumn);
+  if (!index.isValid())
+    return;
+  auto symbolNode = index.data(Qt::UserRole).value<AdsSymbolModel::SymbolNode>();
+  auto adsType = symbolNode.type->adsType();
+
+  Item item;
+  item.key = mNextKey++ & KeyMask;
+  item.fullName = symbolNode.fullName();
+  item.type = Ads::toUnicode(adsType->rawType());
+  item.group = symbolNode.group();
+  item.offset = symbolNode.offset();
+  item.size = adsType->size;
+  item.adsType = adsType;
+  subscribe(item);
+
+  auto row = int(mItems.size());
+  beginInsertRows(QModelIndex(), row, row);
+  mRows.insert(item.key, row);
+  mItems << std::move(item);
+  endInsertRows();
+  mDrainTimer->start();
+}
+
+void WatchModel::subscribe(Item & item)
+{
+  item.notification.reset();
+  item.error.clear();
+  if (!mDevice || mSlot < 0)
+  {
+    item.error = "Not connected";
+    return;
+  }
+
+  AdsNotificationAttrib attributes{};
+  attributes.cbLength = item.size;
+  attributes.nTransMode = item.onChange ? ADSTRANS_SERVERONCHA : ADSTRANS_SERVERCYCLE;
+  attributes.nMaxDelay = 0;
+  attributes.nCycleTime = item.cycleTime * 10000; // in 100 ns
+  try
+  {
+    item.notification = std::make_shared<AdsNotification>(*mDevice, item.group, item.offset, attributes,
+                                                           &WatchModel::onNotification,
+                                                           uint32_t(mSlot) << KeyBits | item.key);
+  }
+  catch (const std::exception & e)
+  {
+    item.error = e.what();
+    qWarning() << "Failed to subscribe to" << item.fullName << ":" << e.what();
+  }
+}
+
+// static
+void WatchModel::onNotification(const AmsAddr * address, const AdsNotificationHeader * header, uint32_t user)
+{
+  Q_UNUSED(address);
+  auto slot = user >> KeyBits;
+  // Counted before the queue is looked up, see ~WatchModel().
+  ++sCallbacksInSlot[slot];
+  if (auto queue = sQueues[slot].load())
+  {
+    queue->push(new NotificationQueue::Sample{
+        user & KeyMask, header->nTimeStamp,
+        QByteArray(reinterpret_cast<const char *>(header + 1), qsizetype(header->cbSampleSize))});
+  }
+  --sCallbacksInSlot[slot];
+}
+
+void WatchModel::drain()
+{
+  // Samples of one item overwrite each other here; the sharing QByteArray
+  // makes that cheap, and only the survivor is ever decoded.
+  mQueue.drain(
+      [&](const NotificationQueue::Sample & sample)
+      {
+        auto row = mRows.value(sample.key, -1);
+        if (row < 0)
+          return; // removed meanwhile
+        auto & item = mItems[row];
+        item.data = sample.data;
+        item.timestamp = sample.timestamp;
+        mCoalescer->markDirty(row);
+      });
+}
+
+int WatchModel::rowCount(const QModelIndex & parent) const
+{
+  return parent.isValid() ? 0 : int(mItems.size());
+}
+
+int WatchModel::columnCount(const QModelIndex & parent) const
+{
+  return parent.isValid() ? 0 : ColumnCount;
+}
+
+QVariant WatchModel::data(const QModelIndex & index, int role) const
+{
+  if (!index.isValid() || index.row() >= mItems.size())
+    return QVariant();
+
+  const auto & item = mItems[index.row()];
+  if (index.column() == OnChangeColumn)
+    return role == Qt::CheckStateRole ? QVariant(item.onChange ? Qt::Checked : Qt::Unchecked) : QVariant();
+  if (role != Qt::DisplayRole && role != Qt::EditRole)
+    return QVariant();
+
+  switch (index.column())
+  {
+    case NameColumn:
+      return item.fullName;
+    case TypeColumn:
+      return item.type;
+    case ValueColumn:
+      if (!item.error.isEmpty())
+        return QString("error: %1").arg(item.error);
+      return item.data.isNull() ? QVariant() : mSymbolModel->valueDecoder().toVariant(item.data, item.adsType);
+    case TimestampColumn:
+      if (item.timestamp == 0)
+        return QString();
+      return QDateTime::fromMSecsSinceEpoch(qint64(item.timestamp - FileTimeToUnixEpoch) / 10000)
+          .toString("hh:mm:ss.zzz");
+    case CycleTimeColumn:
+      return item.cycleTime;
+    default:
+      return QVariant();
+  }
+}
+
+bool WatchModel::setData(const QModelIndex & index, const QVariant & value, int role)
+{
+  if (!index.isValid() || index.row() >= mItems.size())
+    return false;
+
+  auto & item = mItems[index.row()];
+  if (index.column() == CycleTimeColumn && role == Qt::EditRole)
+  {
+    bool ok = false;
+    auto cycleTime = value.toUInt(&ok);
+    if (!ok)
+      return false;
+    item.cycleTime = cycleTime;
+  }
+  else if (index.column() == OnChangeColumn && role == Qt::CheckStateRole)
+  {
+    item.onChange = value.toInt() == Qt::Checked;
+  }
+  else
+  {
+    return false;
+  }
+
+  subscribe(item);
+  emit dataChanged(this->index(index.row(), 0), this->index(index.row(), ColumnCount - 1));
+  return true;
+}
+
+QVariant WatchModel::headerData(int section, Qt::Orientation orientation, int role) const
+{
+  if (role != Qt::DisplayRole || orientation != Qt::Horizontal)
+    return QVariant();
+
+  switch (section)
+  {
+    case NameColumn:
+      return "Name";
+    case TypeColumn:
+      return "Type";
+    case ValueColumn:
+      return "Value";
+    case TimestampColumn:
+      return "Time";
+    case CycleTimeColumn:
+      return "Cycle (ms)";
+    case OnChangeColumn:
+      return "On change";
+    default:
+      return QVariant();
+  }
+}
+
+Qt::ItemFlags WatchModel::flags(const QModelIndex & index) const
+{
+  auto flags = QAbstractTableModel::flags(index);
+  if (!index.isValid())
+    return flags | Qt::ItemIsDropEnabled;
+  if (index.column() == CycleTimeColumn)
+    flags |= Qt::ItemIsEditable;
+  else if (index.column() == OnChangeColumn)
+    flags |= Qt::ItemIsUserCheckable;
+  return flags;
+}
+
+bool WatchModel::removeRows(int row, int count, const QModelIndex & parent)
+{
+  if (parent.isValid() || row < 0 || count <= 0 || row + count > mItems.size())
+    return false;
+
+  beginRemoveRows(parent, row, row + count - 1);
+  mItems.remove(row, count);
+  mRows.clear();
+  for (int i = 0; i < mItems.size(); ++i)
+    mRows.insert(mItems[i].key, i);
+  endRemoveRows();
+  // The pending rows moved up; repaint all that did, in case one was pending.
+  mCoalescer->clear();
+  for (int i = row; i < mItems.size(); ++i)
+    mCoalescer->markDirty(i);
+  if (mItems.isEmpty())
+    mDrainTimer->stop();
+  return true;
+}
+
+QStringList WatchModel::mimeTypes() const
+{
+  return {AdsSymbolModel::RowsMimeType};
+}
+
+Qt::DropActions WatchModel::supportedDropActions() const
+{
+  return Qt::CopyAction;
+}
+
+bool WatchModel::canDropMimeData(const QMimeData * data, Qt::DropAction action, int row, int column,
+                                 const QModelIndex & parent) const
+{
+  Q_UNUSED(row);
+  Q_UNUSED(column);
+  Q_UNUSED(parent);
+  return mSymbolModel && action == Qt::CopyAction && data && data->hasFormat(AdsSymbolModel::RowsMimeType);
+}
+
+bool WatchModel::dropMimeData(const QMimeData * data, Qt::DropAction action, int row, int column,
+                              const QModelIndex & parent)
+{
+  if (!canDropMimeData(data, action, row, column, parent))
+    return false;
+  for (const auto & rows : AdsSymbolModel::rowsFromMimeData(data))
+    addVariable(rows);
+  return true;
+}
@@ -0,0 +1,112 @@
+#pragma once
+
+#include "AdsDatatypeEntry.h"
+#include "AdsDef.h"
+#include "AdsNotificationOOI.h"
+#include "NotificationQueue.h"
+
+#include <QAbstractTableModel>
+#include <QByteArray>
+#include <QList>
+#include <QHash>
+#include <QString>
+#include <QVariant>
+
+#include <cstdint>
+#include <memory>
+
+class AdsDevice;
+class AdsSymbolModel;
+class QAbstractItemView;
+class QTimer;
+class UpdateCoalescer;
+
+// The watch list: variables whose values the target pushes through ADS
+// device notifications, each with its own cycle time and either on change or
+// cyclic transmission. The AdsLib callback only queues the samples; a timer
+// drains the queue into the model in the GUI thread, keeping only the latest
+// raw sample per item. It is decoded when the view asks for it, and an
+// UpdateCoalescer limits the repaints to the visible rows once per frame.
+//
+// Rows of the symbol model (see AdsSymbolModel::RowsMimeType) can be dropped
+// onto it. The cycle time and the mode are edited in their columns.
+class WatchModel : public QAbstractTableModel
+{
+  Q_OBJECT
+
+public: // types
+  enum Columns
+  {
+    NameColumn,
+    TypeColumn,
+    ValueColumn,
+    TimestampColumn,
+    CycleTimeColumn, // ms
+    OnChangeColumn,  // checkable
+    ColumnCount
+  };
+
+public: // methods
+  explicit WatchModel(QObject * parent = nullptr);
+  ~WatchModel() override;
+
+  // Removes all items. The device and the symbol model must outlive their
+  // use here, i.e. until the next setTarget().
+  void setTarget(const AdsDevice * device, const AdsSymbolModel * symbolModel);
+  // rows as for AdsSymbolModel::indexForRows()
+  void addVariable(const QList<int> & rows);
+  // The view whose visible rows get the value updates, see UpdateCoalescer.
+  void setView(QAbstractItemView * view);
+
+  int rowCount(const QModelIndex & parent = QModelIndex()) const override;
+  int columnCount(const QModelIndex & parent = QModelIndex()) const override;
+  QVariant data(const QModelIndex & index, int role = Qt::DisplayRole) const override;
+  bool setData(const QModelIndex & index, const QVariant & value, int role = Qt::EditRole) override;
+  QVariant headerData(int section, Qt::Orientation orientation,
+                      int role = Qt::DisplayRole) const override;
+  Qt::ItemFlags flags(const QModelIndex & index) const override;
+  bool removeRows(int row, int count, const QModelIndex & parent = QModelIndex()) override;
+
+  QStringList mimeTypes() const override;
+  Qt::DropActions supportedDropActions() const override;
+  bool canDropMimeData(const QMimeData * data, Qt::DropAction action, int row, int column,
+                       const QModelIndex & parent) const override;
+  bool dropMimeData(const QMimeData * data, Qt::DropAction action, int row, int column,
+                    const QModelIndex & parent) override;
+
+private: // types
+  struct Item
+  {
+    uint32_t key; // lower bits of the notification's user value
+    QString fullName;
+    QString type;
+    uint32_t group;
+    uint32_t offset;
+    uint32_t size;
+    const AdsDatatypeEntry * adsType; // in the type index of the symbol model
+    uint32_t cycleTime = 100; // ms
+    bool onChange = true;
+    std::shared_ptr<AdsNotification> notification;
+    QByteArray data;        // latest sample
+    uint64_t timestamp = 0; // of data, as in NotificationQueue::Sample
+    QString error;
+  };
+
+private: // methods
+  static void onNotification(const AmsAddr * address, const AdsNotificationHeader * header, uint32_t user);
+  void subscribe(Item & item);
+  void drain();
+  void clear();
+
+private: // attributes
+  const AdsDevice * mDevice = nullptr;
+  const AdsSymbolModel * mSymbolModel = nullptr;
+  QList<Item> mItems;
+  QHash<uint32_t, int> mRows; // key -> row
+  uint32_t mNextKey = 0;
+
+  NotificationQueue mQueue;
+  int mSlot = -1; // of mQueue in the table for onNotification()
+  QTimer * mDrainTimer = nullptr;
+  UpdateCoalescer * mCoalescer = nullptr;
+};
@@ -0,0 +1,72 @@
+#include "BenchmarkSupport.h"
+
+#include <QCommandLineParser>
+#include <QDebug>
+
+#ifdef Q_OS_UNIX
+#include <sys/resource.h>
+#endif
+
+namespace Benchmark
+{
+qint64 peakMemory()
+{
+#ifdef Q_OS_UNIX
+  rusage usage{};
+  getrusage(RUSAGE_SELF, &usage);
+#ifdef Q_OS_MACOS
+  return usage.ru_maxrss;
+#else
+  return qint64(usage.ru_maxrss) * 1024;
+#endif
+#else
+  return -1;
+#endif
+}
+
+void UploadCommandLine::addTo(QCommandLineParser & parser) const
+{
+  parser.addOptions({mSymbols, mDepth, mMembers, mElements, mNameLength});
+}
+
+Synthetic::UploadOptions UploadCommandLine::options(const QCommandLineParser & parser) const
+{
+  Synthetic::UploadOptions options;
+  options.symbols = parser.value(mSymbols).toInt();
+  options.structDepth = parser.value(mDepth).toInt();
+  options.structMembers = parser.value(mMembers).toInt();
+  options.arrayElements = parser.value(mElements).toInt();
+  options.nameLength = parser.value(mNameLength).toInt();
+  return options;
+}
+
+Stage::Stage(const QString & name)
+    : mName(name), mPeakBefore(peakMemory())
+{
+  mTimer.start();
+}
+
+void Stage::finish(qint64 items, const char * unit)
+{
+  auto nsecs = mTimer.nsecsElapsed();
+  qInfo().noquote() << QString("%1: %2 %3s in %4 ms").arg(mName).arg(items).arg(unit).arg(nsecs / 1e6, 0, 'f', 1);
+  if (items > 0)
+    qInfo().noquote() << QString("%1: %2 ns per %3").arg(mName).arg(double(nsecs) / items, 0, 'f', 1).arg(unit);
+
+  auto peak = peakMemory();
+  if (mPeakBefore >= 0 && peak >= 0)
+  {
+    qInfo().noquote() << QString("%1: peak memory %2 KiB, grew by %3 KiB")
+                             .arg(mName)
+                             .arg(peak / 1024)
+                             .arg((peak - mPeakBefore) / 1024);
+    if (items > 0)
+    {
+      qInfo().noquote() << QString("%1: %2 bytes per %3")
+                               .arg(mName)
+                               .arg(double(peak - mPeakBefore) / items, 0, 'f', 1)
+                               .arg(unit);
+    }
+  }
+}
+} // namespace Benchmark
@@ -0,0 +1,49 @@
+#pragma once
+
+#include "SyntheticUpload.h"
+
+#include <QCommandLineOption>
+#include <QElapsedTimer>
+#include <QString>
+
+class QCommandLineParser;
+
+namespace Benchmark
+{
+// Peak resident memory of the process in bytes, -1 if unknown.
+qint64 peakMemory();
+
+// The command line options for the size of the synthetic upload.
+class UploadCommandLine
+{
+public: // methods
+  void addTo(QCommandLineParser & parser) const;
+  // After the parser processed the arguments.
+  Synthetic::UploadOptions options(const QCommandLineParser & parser) const;
+
+private: // attributes
+  QCommandLineOption mSymbols{"symbols", "Number of top-level symbols.", "count", "1000"};
+  QCommandLineOption mDepth{"depth", "Struct nesting depth.", "count", "3"};
+  QCommandLineOption mMembers{"members", "Members per struct.", "count", "8"};
+  QCommandLineOption mElements{"elements", "Array elements per struct.", "count", "100"};
+  QCommandLineOption mNameLength{"name-length", "Length of the names.", "count", "16"};
+};
+
+// Times a stage from construction to finish() and reports how long it took and
+// how much the peak memory of the process grew meanwhile, in total and per
+// item. The growth is only meaningful for the first stage that raises the
+// peak, so each stage runs in a process of its own.
+class Stage
+{
+public: // methods
+  explicit Stage(const QString & name);
+
+  // items counts what the stage produced or visited; unit names one of them.
+  void finish(qint64 items, const char * unit);
+
+private: // attributes
+  QString mName;
+  QElapsedTimer mTimer;
+  qint64 mPeakBefore;
+};
+} // namespace Benchmark
@@ -0,0 +1,216 @@
+// Times one stage of the way from the raw uploads to what the browser shows,
+// on a synthetic upload: building the indexes, expanding the types, walking
+// and indexing all rows, traversing the model, searching, decoding values and
+// exporting. The stages before the timed one are set up untimed. Each stage
+// runs in a process of its own, so the growth of the peak memory is its own.
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDebug>
+#include <QTemporaryDir>
+
+#include "AdsDatatypeIndex.h"
+#include "AdsPathIndex.h"
+#include "AdsPathSpace.h"
+#include "AdsSymbolIndex.h"
+#include "AdsSymbolModel.h"
+#include "AdsValueDecoder.h"
+#include "BenchmarkSupport.h"
+#include "SymbolExport.h"
+#include "SymbolQuery.h"
+#include "SymbolSearch.h"
+
+#include <memory>
+
+// Finds every struct and array row but no INT. Having no text, it walks all
+// rows without the trigram index ruling any out.
+static constexpr const char * DefaultQuery = "-type:INT";
+
+// Visits every row below parent, as a view expanding everything would.
+static qsizetype traverse(const QAbstractItemModel & model, const QModelIndex & parent)
+{
+  qsizetype rows = 0;
+  auto rowCount = model.rowCount(parent);
+  for (int row = 0; row < rowCount; ++row)
+  {
+    auto index = model.index(row, AdsSymbolModel::NameColumn, parent);
+    model.data(index);
+    rows += 1 + traverse(model, index);
+  }
+  return rows;
+}
+
+// Creates all entries below entry.
+static qsizetype expand(const AdsDatatypeIndex::Entry * entry, const AdsDatatypeIndex & index)
+{
+  qsizetype entries = 0;
+  auto childCount = entry->childCount(index);
+  for (int row = 0; row < childCount; ++row)
+    entries += 1 + expand(entry->child(row, index), index);
+  return entries;
+}
+
+static std::unique_ptr<AdsSymbolModel> buildModel(const Synthetic::Upload & upload)
+{
+  return std::make_unique<AdsSymbolModel>(AdsDatatypeIndex(upload.datatypes), AdsSymbolIndex(upload.symbols));
+}
+
+static bool exportTo(const AdsSymbolModel & model, SymbolExport::Format format, const QString & stage)
+{
+  QTemporaryDir dir;
+  SymbolExport symbolExport(model, format, dir.filePath("export"));
+  Benchmark::Stage timing(stage);
+  symbolExport.start();
+  symbolExport.wait();
+  timing.finish(symbolExport.entryCount(), "row");
+  if (!symbolExport.errorString().isEmpty())
+  {
+    qWarning().noquote() << stage << "failed:" << symbolExport.errorString();
+    return false;
+  }
+  return true;
+}
+
+int main(int argc, char * argv[])
+{
+  QCoreApplication app(argc, argv);
+
+  static const QStringList stages = {"symbol-index", "datatype-index", "type-entries", "model",
+                                     "model-traversal", "path-space", "path-index", "search",
+                                     "decode", "export-csv", "export-columns"};
+
+  QCommandLineParser parser;
+  parser.addHelpOption();
+  QCommandLineOption stageOption("stage", QString("The stage to time: %1.").arg(stages.join(", ")), "stage");
+  QCommandLineOption queryOption("query", "Search text of the search stage.", "text", DefaultQuery);
+  parser.addOptions({stageOption, queryOption});
+  Benchmark::UploadCommandLine uploadCommandLine;
+  uploadCommandLine.addTo(parser);
+  parser.process(app);
+
+  auto stage = parser.value(stageOption);
+  if (!stages.contains(stage))
+  {
+    qWarning().noquote() << "Unknown stage" << stage;
+    parser.showHelp(1);
+  }
+
+  auto upload = Synthetic::generateUpload(uploadCommandLine.options(parser));
+  qInfo().noquote() << QString("Upload of %1 symbols (%2 bytes), %3 data types (%4 bytes)")
+                           .arg(upload.symbolCount)
+                           .arg(upload.symbols.size())
+                           .arg(upload.datatypeCount)
+                           .arg(upload.datatypes.size());
+
+  if (stage == "symbol-index")
+  {
+    Benchmark::Stage timing(stage);
+    AdsSymbolIndex symbolIndex(upload.symbols);
+    timing.finish(symbolIndex.count(), "record");
+  }
+  else if (stage == "datatype-index")
+  {
+    Benchmark::Stage timing(stage);
+    AdsDatatypeIndex typeIndex(upload.datatypes);
+    timing.finish(typeIndex.count(), "record");
+  }
+  else if (stage == "type-entries")
+  {
+    AdsDatatypeIndex typeIndex(upload.datatypes);
+    Benchmark::Stage timing(stage);
+    qsizetype entries = 0;
+    for (qsizetype i = 0; i < typeIndex.count(); ++i)
+      entries += 1 + expand(typeIndex.entry(i), typeIndex);
+    timing.finish(entries, "node");
+  }
+  else if (stage == "model")
+  {
+    AdsDatatypeIndex typeIndex(upload.datatypes);
+    AdsSymbolIndex symbolIndex(upload.symbols);
+    Benchmark::Stage timing(stage);
+    AdsSymbolModel model(std::move(typeIndex), std::move(symbolIndex));
+    timing.finish(model.pathSpace().rowCount(), "row");
+  }
+  else if (stage == "model-traversal")
+  {
+    auto model = buildModel(upload);
+    Benchmark::Stage timing(stage);
+    timing.finish(traverse(*model, QModelIndex()), "row");
+  }
+  else if (stage == "path-space")
+  {
+    auto model = buildModel(upload);
+    const auto & pathSpace = model->pathSpace();
+    Benchmark::Stage timing(stage);
+    quint64 rows = 0;
+    pathSpace.walk(0, pathSpace.rowCount(),
+                   [&](quint64, const AdsDatatypeEntry *, const AdsPathSpace::Cursor &)
+                   {
+                     ++rows;
+                     return true;
+                   });
+    timing.finish(rows, "row");
+  }
+  else if (stage == "path-index")
+  {
+    auto model = buildModel(upload);
+    Benchmark::Stage timing(stage);
+    auto pathIndex = AdsPathIndex::build(model->pathSpace());
+    timing.finish(model->pathSpace().rowCount(), "row");
+    qInfo().noquote() << QString("%1: %2 KiB").arg(stage).arg(pathIndex.data().size() / 1024);
+  }
+  else if (stage == "search")
+  {
+    auto model = buildModel(upload);
+    model->setPathIndex(AdsPathIndex::build(model->pathSpace()));
+    auto query = SymbolQuery::parse(parser.value(queryOption));
+    if (!query.isValid())
+    {
+      qWarning().noquote() << "Invalid query" << parser.value(queryOption);
+      return 1;
+    }
+    SymbolSearch search(model->pathSpace(), model->pathIndex(), query);
+    Benchmark::Stage timing(stage);
+    search.start();
+    search.wait();
+    timing.finish(search.hitCount(), "hit");
+    if (search.isTruncated())
+      qInfo().noquote() << QString("%1: the hits were truncated").arg(stage);
+  }
+  else if (stage == "decode")
+  {
+    auto model = buildModel(upload);
+    const auto & symbolIndex = model->symbolIndex();
+    const auto & decoder = model->valueDecoder();
+    Benchmark::Stage timing(stage);
+    qint64 leaves = 0;
+    for (qsizetype i = 0; i < symbolIndex.count(); ++i)
+    {
+      auto symbol = symbolIndex.entry(i);
+      auto adsType = model->typeIndex().lookupRecord(symbol->rawType());
+      if (!adsType)
+        continue;
+      decoder.decode(QByteArray(symbol->size, '\0'), adsType,
+                     [&](const QByteArray &, const QVariant &)
+                     {
+                       ++leaves;
+                       return true;
+                     });
+    }
+    timing.finish(leaves, "leaf value");
+  }
+  else if (stage == "export-csv")
+  {
+    auto model = buildModel(upload);
+    if (!exportTo(*model, SymbolExport::Format::LeavesCsv, stage))
+      return 1;
+  }
+  else if (stage == "export-columns")
+  {
+    auto model = buildModel(upload);
+    if (!exportTo(*model, SymbolExport::Format::Columns, stage))
+      return 1;
+  }
+
+  return 0;
+}
@@ -0,0 +1,78 @@
+// Times a full recursive traversal of AdsSymbolModel through a
+// QSortFilterProxyModel with recursive filtering, the way the filter line of
+// the browser uses it, on a synthetic upload.
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QSortFilterProxyModel>
+
+#include "AdsDatatypeIndex.h"
+#include "AdsSymbolIndex.h"
+#include "AdsSymbolModel.h"
+#include "BenchmarkSupport.h"
+
+// Visits every row below parent, checking that parent() finds the way back.
+static qsizetype traverse(const QAbstractItemModel & model, const QModelIndex & parent)
+{
+  qsizetype rows = 0;
+  auto rowCount = model.rowCount(parent);
+  for (int row = 0; row < rowCount; ++row)
+  {
+    auto index = model.index(row, AdsSymbolModel::NameColumn, parent);
+    if (Q_UNLIKELY(model.parent(index) != parent))
+      qFatal("parent() does not lead back to the parent of row %d", row);
+    model.data(index);
+    rows += 1 + traverse(model, index);
+  }
+  return rows;
+}
+
+int main(int argc, char * argv[])
+{
+  QCoreApplication app(argc, argv);
+
+  QCommandLineParser parser;
+  parser.addHelpOption();
+  Benchmark::UploadCommandLine uploadCommandLine;
+  uploadCommandLine.addTo(parser);
+  parser.process(app);
+
+  auto options = uploadCommandLine.options(parser);
+  auto upload = Synthetic::generateUpload(options);
+
+  QElapsedTimer timer;
+  timer.start();
+  AdsSymbolModel model(AdsDatatypeIndex(upload.datatypes), AdsSymbolIndex(upload.symbols));
+  qInfo() << "Model built in" << timer.elapsed() << "ms," << model.rowCount() << "symbols";
+
+  QSortFilterProxyModel proxy;
+  proxy.setRecursiveFilteringEnabled(true);
+  proxy.setFilterKeyColumn(AdsSymbolModel::NameColumn);
+  proxy.setSourceModel(&model);
+
+  // Nothing matches, so the filter has to look at every row of the source.
+  auto memoryBefore = Benchmark::peakMemory();
+  timer.restart();
+  proxy.setFilterFixedString("no such name");
+  qInfo() << "Recursive filter without match in" << timer.elapsed() << "ms";
+
+  // The source nodes all exist by now; count them with a plain traversal.
+  proxy.setFilterFixedString(QString());
+  timer.restart();
+  auto sourceRows = traverse(model, QModelIndex());
+  qInfo() << "Source traversal of" << sourceRows << "rows in" << timer.elapsed() << "ms";
+  auto memoryAfter = Benchmark::peakMemory();
+  if (memoryBefore >= 0 && sourceRows > 0)
+    qInfo() << "Peak memory grew by" << (memoryAfter - memoryBefore) / 1024 << "KiB,"
+            << double(memoryAfter - memoryBefore) / sourceRows << "bytes per row";
+
+  // Every symbol matches through its deepest members.
+  proxy.setFilterFixedString(QString("m%1").arg(options.structMembers - 1));
+  timer.restart();
+  auto proxyRows = traverse(proxy, QModelIndex());
+  qInfo() << "Proxy traversal of" << proxyRows << "rows in" << timer.elapsed() << "ms";
+
+  return 0;
+}
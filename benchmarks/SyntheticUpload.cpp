@@ -0,0 +1,130 @@
+#include "SyntheticUpload.h"
+
+#include "AdsDatatypeEntry.h"
+#include "AdsDef.h"
+
+#include <QList>
+
+#include <algorithm>
+#include <cstring>
+
+namespace
+{
+constexpr uint32_t SymbolGroup = 0x4040;
+constexpr uint32_t IntSize = 2;
+
+QByteArray paddedName(const QByteArray & prefix, int number, int length)
+{
+  return (prefix + QByteArray::number(number)).leftJustified(length, '_');
+}
+
+QByteArray datatypeRecord(const QByteArray & name, const QByteArray & type, uint32_t size, uint32_t offs,
+                          AdsDatatypeId dataType, uint32_t flags,
+                          const QList<AdsDatatypeArrayInfo> & arrayInfo = {},
+                          const QByteArray & subItems = {}, int subItemCount = 0)
+{
+  AdsDatatypeEntry header{};
+  header.version = ADSDATATYPE_VERSION_NEWEST;
+  header.size = size;
+  header.offs = offs;
+  header.dataType = uint32_t(dataType);
+  header.flags = flags;
+  header.nameLength = uint16_t(name.size());
+  header.typeLength = uint16_t(type.size());
+  header.commentLength = 0;
+  header.arrayDim = uint16_t(arrayInfo.size());
+  header.subItemCount = uint16_t(subItemCount);
+
+  QByteArray record(reinterpret_cast<const char *>(&header), sizeof(header));
+  record.append(name).append('\0');
+  record.append(type).append('\0');
+  record.append('\0'); // empty comment
+  for (const auto & info : arrayInfo)
+    record.append(reinterpret_cast<const char *>(&info), sizeof(info));
+  record.append(subItems);
+
+  auto entryLength = uint32_t(record.size());
+  std::memcpy(record.data(), &entryLength, sizeof(entryLength));
+  return record;
+}
+
+QByteArray symbolRecord(const QByteArray & name, const QByteArray & type, uint32_t offset, uint32_t size)
+{
+  AdsSymbolEntry header{};
+  header.iGroup = SymbolGroup;
+  header.iOffs = offset;
+  header.size = size;
+  header.dataType = uint32_t(AdsDatatypeId::BigType);
+  header.nameLength = uint16_t(name.size());
+  header.typeLength = uint16_t(type.size());
+  header.commentLength = 0;
+
+  QByteArray record(reinterpret_cast<const char *>(&header), sizeof(header));
+  record.append(name).append('\0');
+  record.append(type).append('\0');
+  record.append('\0'); // empty comment
+
+  auto entryLength = uint32_t(record.size());
+  std::memcpy(record.data(), &entryLength, sizeof(entryLength));
+  return record;
+}
+} // namespace
+
+namespace Synthetic
+{
+Upload generateUpload(const UploadOptions & options)
+{
+  Upload upload;
+  auto structDepth = std::max(options.structDepth, 1);
+  auto structMembers = std::max(options.structMembers, 2);
+  auto arrayElements = uint32_t(std::max(options.arrayElements, 1));
+
+  upload.datatypes += datatypeRecord("INT", QByteArray(), IntSize, 0, AdsDatatypeId::Int16, ADSDATATYPEFLAG_DATATYPE);
+  auto arrayType = "ARRAY [0.." + QByteArray::number(arrayElements - 1) + "] OF INT";
+  upload.datatypes += datatypeRecord(arrayType, "INT", arrayElements * IntSize, 0, AdsDatatypeId::Int16,
+                                     ADSDATATYPEFLAG_DATATYPE, {AdsDatatypeArrayInfo{0, arrayElements}});
+  upload.datatypeCount = 2;
+
+  // The deepest level first, so each level knows the size of the next.
+  uint32_t nextLevelSize = 0;
+  QByteArray nextLevelType;
+  for (int level = structDepth - 1; level >= 0; --level)
+  {
+    QByteArray subItems;
+    uint32_t offset = 0;
+    for (int iMember = 0; iMember < structMembers; ++iMember)
+    {
+      auto name = paddedName("m", iMember, options.nameLength);
+      if (iMember == 0 && !nextLevelType.isEmpty())
+      {
+        subItems += datatypeRecord(name, nextLevelType, nextLevelSize, offset, AdsDatatypeId::BigType, ADSDATATYPEFLAG_DATAITEM);
+        offset += nextLevelSize;
+      }
+      else if (iMember == 1)
+      {
+        subItems += datatypeRecord(name, arrayType, arrayElements * IntSize, offset, AdsDatatypeId::Int16, ADSDATATYPEFLAG_DATAITEM);
+        offset += arrayElements * IntSize;
+      }
+      else
+      {
+        subItems += datatypeRecord(name, "INT", IntSize, offset, AdsDatatypeId::Int16, ADSDATATYPEFLAG_DATAITEM);
+        offset += IntSize;
+      }
+    }
+    nextLevelType = "ST_Level" + QByteArray::number(level);
+    nextLevelSize = offset;
+    upload.datatypes += datatypeRecord(nextLevelType, QByteArray(), offset, 0, AdsDatatypeId::BigType,
+                                       ADSDATATYPEFLAG_DATATYPE, {}, subItems, structMembers);
+    ++upload.datatypeCount;
+  }
+
+  uint32_t offset = 0;
+  for (int iSymbol = 0; iSymbol < options.symbols; ++iSymbol)
+  {
+    upload.symbols += symbolRecord("MAIN." + paddedName("s", iSymbol, options.nameLength), nextLevelType, offset, nextLevelSize);
+    offset += nextLevelSize;
+  }
+  upload.symbolCount = options.symbols;
+  return upload;
+}
+} // namespace Synthetic
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <QByteArray>
+
+namespace Synthetic
+{
+struct UploadOptions
+{
+  int symbols = 1000;        // top-level symbols, all of type ST_Level0
+  int structDepth = 3;       // ST_Level0 .. ST_Level<depth - 1>
+  int structMembers = 8;     // members per struct, at least 2
+  int arrayElements = 100;   // elements of the INT array in each struct
+  int nameLength = 16;       // length of the symbol and member names
+};
+
+// Valid ADSIGRP_SYM_UPLOAD and ADSIGRP_SYM_DT_UPLOAD blobs. Every struct holds
+// a member of the next level (except the deepest), an ARRAY [0..n-1] OF INT
+// and INT members for the rest.
+struct Upload
+{
+  QByteArray symbols;
+  QByteArray datatypes;
+  int symbolCount = 0;
+  int datatypeCount = 0;
+};
+
+Upload generateUpload(const UploadOptions & options);
+} // namespace Synthetic